@@ -0,0 +1,140 @@
+// process_batch lookahead sweep on cancel-heavy flow
+//
+// The book is pre-filled with `live` resting orders spread over a wide
+// price band, then each step either cancels a random live order (60%),
+// adds a non-crossing limit order (35%) or sends a small market order (5%).
+// Random cancels land all over the order pool, the id index and the ladder,
+// so each one misses cache unless its lines were prefetched.
+//
+// Also prints the resting Orders' footprint at each size.
+//
+// Usage: ./bench_batch [messages]
+
+#include "../include/OrderBook.h"
+#include "bench_util.h"
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+namespace {
+
+using namespace bench;
+using Book = BasicOrderBook<NullEventHandler>;
+
+Msg make(MsgType type, Side side, OrderId id, Price price, Quantity qty) {
+    Msg msg{};
+    msg.type = type;
+    msg.side = side;
+    msg.id = id;
+    msg.price = price;
+    msg.qty = qty;
+    return msg;
+}
+
+struct Flow {
+    std::vector<Msg> prefill;
+    std::vector<Msg> steps;
+};
+
+Flow make_flow(size_t live, size_t count) {
+    Rng rng;
+    Flow flow;
+    std::vector<OrderId> ids;
+    ids.reserve(live);
+    OrderId next_id = 1;
+    const Price MID = 100000;
+    const Price BAND = 1500;  // ticks either side, inside the ladder window
+
+    auto add_limit = [&](std::vector<Msg>& out) {
+        Side side = (rng.next() & 1) ? Side::Buy : Side::Sell;
+        Price offset = 1 + static_cast<Price>(rng.next() % BAND);
+        Price price = side == Side::Buy ? MID - offset : MID + offset;
+        out.push_back(make(MsgType::NewLimit, side, next_id, price, 1 + static_cast<Quantity>(rng.next() % 100)));
+        return next_id++;
+    };
+
+    for (size_t i = 0; i < live; ++i) ids.push_back(add_limit(flow.prefill));
+
+    flow.steps.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        uint64_t roll = rng.next() % 100;
+        if (roll < 60 && !ids.empty()) {
+            size_t k = rng.next() % ids.size();
+            flow.steps.push_back(make(MsgType::Cancel, Side::Buy, ids[k], 0, 0));
+            ids[k] = ids.back();
+            ids.pop_back();
+        } else if (roll < 95) {
+            ids.push_back(add_limit(flow.steps));
+        } else {
+            Side side = (rng.next() & 1) ? Side::Buy : Side::Sell;
+            flow.steps.push_back(make(MsgType::NewMarket, side, next_id++, 0, 1 + static_cast<Quantity>(rng.next() % 20)));
+        }
+    }
+    return flow;
+}
+
+// Returns ns/msg; checksum must match across runs
+template <typename Run>
+double run(const Flow& flow, Quantity& checksum, Run&& process) {
+    Book book;
+    book.process_batch(flow.prefill, 0);
+    double ns = time_ns_per_op(flow.steps.size(), [&] { process(book); });
+    checksum = book.total_bid_qty() * 31 + book.total_ask_qty() + static_cast<Quantity>(book.get_total_trades());
+    return ns;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    size_t messages = 4'000'000;
+    if (argc > 1) {
+        messages = std::strtoull(argv[1], nullptr, 10);
+        if (messages == 0) messages = 4'000'000;
+    }
+    const size_t BATCH = 4096;  // messages per process_batch call
+
+    for (size_t live : {size_t(100'000), size_t(1'000'000)}) {
+        Flow flow = make_flow(live, messages);
+
+        std::cout << "=== process_batch, cancel-heavy, " << live << " live orders (ns/msg) ===" << std::endl;
+        // Resting-order footprint the flow walks (hot records, plus the cold
+        // array with ENABLE_ORDER_HOT_COLD_SPLIT)
+        size_t cold = ENABLE_ORDER_HOT_COLD_SPLIT ? sizeof(OrderCold) : 0;
+        std::cout << "Order: " << sizeof(Order) << " B hot + " << cold << " B cold, "
+                  << std::fixed << std::setprecision(1) << live * sizeof(Order) / 1048576.0 << " + "
+                  << live * cold / 1048576.0 << " MB at the prefill" << std::endl;
+        std::cout << std::left << std::setw(24) << "mode"
+                  << std::right << std::setw(10) << "ns/msg"
+                  << std::setw(10) << "speedup" << std::endl;
+
+        Quantity reference = 0;
+        double base = run(flow, reference, [&](Book& book) {
+            for (const Msg& msg : flow.steps) book.process_message(msg);
+        });
+        std::cout << std::left << std::setw(24) << "process_message"
+                  << std::right << std::fixed << std::setprecision(1) << std::setw(10) << base
+                  << std::setw(10) << "1.00" << std::endl;
+
+        for (size_t lookahead : {size_t(0), size_t(1), size_t(2), size_t(4), size_t(8),
+                                 size_t(16), size_t(32), size_t(64)}) {
+            Quantity checksum = 0;
+            double ns = run(flow, checksum, [&](Book& book) {
+                std::span<const Msg> all(flow.steps);
+                for (size_t i = 0; i < all.size(); i += BATCH) {
+                    book.process_batch(all.subspan(i, std::min(BATCH, all.size() - i)), lookahead);
+                }
+            });
+            if (checksum != reference) {
+                std::cerr << "result mismatch at lookahead " << lookahead << std::endl;
+                return 1;
+            }
+            std::cout << std::left << std::setw(24) << ("batch, lookahead " + std::to_string(lookahead))
+                      << std::right << std::fixed << std::setprecision(1) << std::setw(10) << ns
+                      << std::setw(10) << std::setprecision(2) << base / ns << std::endl;
+        }
+        std::cout << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,200 @@
+// Cancel latency against book depth
+//
+// Each side holds `live` resting orders spread evenly over `depth` price
+// levels (1 tick apart from the touch outwards), so the order pool and id
+// index footprint is the same at every depth and only the level count
+// changes. Each op cancels a random resting order; an untimed limit order
+// then rejoins the back of the same level, so levels never empty and the
+// book keeps its shape. A cancel is an id-index probe plus an unlink through
+// the order's level handle, so its cost should not grow with depth on either
+// level backend (the std::map one included).
+//
+// Every cancel is timed on its own with TSC reads (the empty-timer cost is
+// subtracted) and reported as p50 / p90 / p99 / mean ns.
+//
+// Usage: ./bench_cancel [--depth 10,100,1000,10000] [--live 40000]
+//                       [--books default,map] [--ops 200000]
+
+#include "../include/OrderBook.h"
+#include "bench_util.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+using namespace bench;
+
+// The std::map build: one tree node per level, hash index for sparse ids
+struct MapBookPolicy : DefaultBookPolicy {
+    template <Side S>
+    using book_side = MapBookSide<S>;
+    using order_index = FlatOrderIndex;
+};
+
+using DefaultBook = BasicOrderBook<NullEventHandler>;
+using MapBook = BasicOrderBook<NullEventHandler, MapBookPolicy>;
+
+constexpr Price MID = 1000000;
+constexpr Quantity QTY = 10;
+
+struct Config {
+    std::vector<size_t> depths = {10, 100, 1000, 10000};
+    std::vector<std::string> books = {"default", "map"};
+    size_t live = 40000;
+    size_t ops = 200000;
+};
+
+std::vector<size_t> parse_list(const char* arg) {
+    std::vector<size_t> out;
+    for (const char* p = arg; *p;) {
+        char* end;
+        size_t v = std::strtoull(p, &end, 10);
+        if (end == p) break;
+        if (v > 0) out.push_back(v);
+        p = (*end == ',') ? end + 1 : end;
+    }
+    return out;
+}
+
+std::vector<std::string> parse_names(const char* arg) {
+    std::vector<std::string> out;
+    for (const char* p = arg; *p;) {
+        const char* comma = std::strchr(p, ',');
+        size_t len = comma ? static_cast<size_t>(comma - p) : std::strlen(p);
+        if (len > 0) out.emplace_back(p, len);
+        p = comma ? comma + 1 : p + len;
+    }
+    return out;
+}
+
+ALWAYS_INLINE uint64_t ticks() noexcept { return clock_now<ClockSource::Tsc>(); }
+
+uint64_t timer_overhead_ticks() {
+    std::vector<uint64_t> samples(10000);
+    for (uint64_t& s : samples) {
+        uint64_t t0 = ticks();
+        clobber_memory();
+        s = ticks() - t0;
+    }
+    std::nth_element(samples.begin(), samples.begin() + samples.size() / 2, samples.end());
+    return samples[samples.size() / 2];
+}
+
+Msg make(MsgType type, Side side, OrderId id, Price price, Quantity qty) {
+    Msg msg{};
+    msg.type = type;
+    msg.side = side;
+    msg.id = id;
+    msg.price = price;
+    msg.qty = qty;
+    return msg;
+}
+
+Price level_price(Side side, size_t level) {
+    Price offset = 1 + static_cast<Price>(level);
+    return side == Side::Buy ? MID - offset : MID + offset;
+}
+
+struct Percentiles {
+    double p50, p90, p99, mean;
+};
+
+// Resting orders are tracked as (side, level) per slot; a cancelled slot is
+// refilled with a fresh id at the same level
+template <typename Book>
+Percentiles run(const Config& cfg, size_t depth, uint64_t overhead, double ticks_per_ns) {
+    Book book;
+    struct Slot {
+        OrderId id;
+        Side side;
+        uint32_t level;
+    };
+    std::vector<Slot> slots;
+    slots.reserve(2 * cfg.live);
+    OrderId next_id = 1;
+    for (size_t k = 0; k < cfg.live; ++k) {
+        for (Side side : {Side::Buy, Side::Sell}) {
+            uint32_t level = static_cast<uint32_t>(k % depth);
+            book.process_message(make(MsgType::NewLimit, side, next_id, level_price(side, level), QTY));
+            slots.push_back({next_id++, side, level});
+        }
+    }
+
+    Rng rng;
+    std::vector<uint64_t> samples;
+    samples.reserve(cfg.ops);
+    for (size_t i = 0; i < cfg.ops; ++i) {
+        Slot& slot = slots[rng.next() % slots.size()];
+        Msg cancel = make(MsgType::Cancel, slot.side, slot.id, 0, 0);
+
+        uint64_t t0 = ticks();
+        book.process_message(cancel);
+        uint64_t elapsed = ticks() - t0;
+        samples.push_back(elapsed > overhead ? elapsed - overhead : 0);
+
+        slot.id = next_id++;
+        book.process_message(make(MsgType::NewLimit, slot.side, slot.id, level_price(slot.side, slot.level), QTY));
+    }
+    g_sink = static_cast<int64_t>(book.get_total_messages());
+
+    std::sort(samples.begin(), samples.end());
+    auto at = [&](double q) { return samples[static_cast<size_t>(q * (samples.size() - 1))] / ticks_per_ns; };
+    double sum = 0;
+    for (uint64_t s : samples) sum += static_cast<double>(s);
+    return {at(0.50), at(0.90), at(0.99), sum / samples.size() / ticks_per_ns};
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    Config cfg;
+    bool bad_arg = false;   // unknown option, or an option missing its value
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--depth") == 0 && i + 1 < argc) {
+            cfg.depths = parse_list(argv[++i]);
+        } else if (strcmp(argv[i], "--live") == 0 && i + 1 < argc) {
+            cfg.live = std::strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--books") == 0 && i + 1 < argc) {
+            cfg.books = parse_names(argv[++i]);
+        } else if (strcmp(argv[i], "--ops") == 0 && i + 1 < argc) {
+            cfg.ops = std::strtoull(argv[++i], nullptr, 10);
+        } else {
+            bad_arg = true;
+        }
+    }
+    bool books_ok = !cfg.books.empty();
+    for (const std::string& b : cfg.books) books_ok = books_ok && (b == "default" || b == "map");
+    if (bad_arg || cfg.depths.empty() || cfg.live == 0 || cfg.ops == 0 || !books_ok) {
+        std::cerr << "Usage: " << argv[0] << " [--depth 10,100,1000,10000] [--live <orders per side>]"
+                  << " [--books default,map] [--ops <n>]" << std::endl;
+        return 1;
+    }
+
+    double ticks_per_ns = tsc_ticks_per_ns();
+    uint64_t overhead = timer_overhead_ticks();
+
+    std::cout << "=== Cancel latency vs depth (" << cfg.live << " resting orders per side, "
+              << cfg.ops << " cancels) ===" << std::endl;
+    std::cout << "timer overhead " << std::fixed << std::setprecision(1) << overhead / ticks_per_ns
+              << " ns (subtracted)\n" << std::endl;
+    std::cout << std::left << std::setw(9) << "book" << std::right << std::setw(8) << "depth"
+              << std::setw(12) << "orders/lvl" << std::setw(8) << "p50" << std::setw(8) << "p90"
+              << std::setw(8) << "p99" << std::setw(8) << "mean" << std::endl;
+
+    for (const std::string& book : cfg.books) {
+        for (size_t depth : cfg.depths) {
+            if (depth > cfg.live) continue;
+            Percentiles p = book == "map" ? run<MapBook>(cfg, depth, overhead, ticks_per_ns)
+                                          : run<DefaultBook>(cfg, depth, overhead, ticks_per_ns);
+            std::cout << std::left << std::setw(9) << book << std::right << std::setw(8) << depth
+                      << std::setw(12) << cfg.live / depth << std::setprecision(1) << std::setw(8) << p.p50
+                      << std::setw(8) << p.p90 << std::setw(8) << p.p99 << std::setw(8) << p.mean << std::endl;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,131 @@
+// L2 delta publish cost and volume: no market data, raw per-change deltas,
+// conflated per message, conflated per batch, and a seqlock-published top-10
+// (its "deltas" column counts snapshots published)
+//
+// The flow is sweep-heavy (large marketable limits and market orders walking
+// several levels) so conflation has something to coalesce.
+//
+// Usage: ./bench_market_data [messages]
+
+#include "../include/OrderBook.h"
+#include "bench_util.h"
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+using namespace bench;
+
+// Publish sink that only counts deltas
+struct CountingSink : NullEventHandler {
+    uint64_t deltas = 0;
+    ALWAYS_INLINE void on_level_update(const L2Delta&) { deltas++; }
+};
+
+std::vector<Msg> make_flow(size_t count) {
+    Rng rng;
+    std::vector<Msg> flow(count);
+    std::vector<OrderId> live;
+    for (size_t i = 0; i < count; ++i) {
+        Msg& msg = flow[i];
+        msg.id = i + 1;
+        msg.symbol = 0;
+        msg.side = (rng.next() & 1) ? Side::Buy : Side::Sell;
+        uint64_t roll = rng.next() % 100;
+        if (roll < 15 && !live.empty()) {
+            size_t k = rng.next() % live.size();
+            msg.type = MsgType::Cancel;
+            msg.id = live[k];
+            msg.price = 0;
+            msg.qty = 0;
+            live[k] = live.back();
+            live.pop_back();
+        } else if (roll < 25) {
+            msg.type = MsgType::NewMarket;
+            msg.price = 0;
+            msg.qty = 50 + static_cast<Quantity>(rng.next() % 400);  // walks levels
+        } else {
+            msg.type = MsgType::NewLimit;
+            Price offset = static_cast<Price>(rng.next() % 20);
+            msg.price = msg.side == Side::Buy ? 9990 + offset : 10000 - offset + 10;
+            msg.qty = 1 + static_cast<Quantity>(rng.next() % 50);
+            live.push_back(msg.id);
+        }
+    }
+    return flow;
+}
+
+template <typename Book, typename AfterBatch>
+void run_case(const std::string& name, const std::vector<Msg>& flow, size_t batch,
+              Book& book, AfterBatch after_batch, uint64_t (*published)(const Book&)) {
+    double ns = time_ns_per_op(flow.size(), [&] {
+        for (size_t i = 0; i < flow.size(); ++i) {
+            book.process_message(flow[i]);
+            if ((i + 1) % batch == 0) after_batch(book);
+        }
+        after_batch(book);
+    });
+    uint64_t deltas = published(book);
+    std::cout << std::left << std::setw(22) << name
+              << std::right << std::fixed << std::setprecision(1)
+              << std::setw(12) << ns
+              << std::setw(14) << deltas
+              << std::setw(14) << std::setprecision(3) << static_cast<double>(deltas) / flow.size()
+              << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    size_t messages = 2'000'000;
+    if (argc > 1) {
+        messages = std::strtoull(argv[1], nullptr, 10);
+        if (messages == 0) messages = 2'000'000;
+    }
+    const size_t BATCH = 1024;
+
+    std::vector<Msg> flow = make_flow(messages);
+
+    std::cout << "=== L2 market data (" << messages << " messages) ===" << std::endl;
+    std::cout << std::left << std::setw(22) << "handler"
+              << std::right << std::setw(12) << "ns/msg"
+              << std::setw(14) << "deltas"
+              << std::setw(14) << "deltas/msg" << std::endl;
+
+    {
+        BasicOrderBook<NullEventHandler> book;
+        run_case("none", flow, BATCH, book, [](auto&) {},
+                 +[](const BasicOrderBook<NullEventHandler>&) -> uint64_t { return 0; });
+    }
+    {
+        using Book = BasicOrderBook<CountingSink>;
+        Book book;
+        run_case("raw", flow, BATCH, book, [](auto&) {},
+                 +[](const Book& b) -> uint64_t { return b.handler().deltas; });
+    }
+    {
+        using Book = BasicOrderBook<L2Conflator<CountingSink>>;
+        Book book;
+        run_case("conflated/message", flow, BATCH, book, [](auto&) {},
+                 +[](const Book& b) -> uint64_t { return b.handler().published(); });
+    }
+    {
+        using Book = BasicOrderBook<L2Conflator<CountingSink>>;
+        Book book(L2Conflator<CountingSink>(ConflationWindow::Batch));
+        run_case("conflated/batch1024", flow, BATCH, book, [](auto& b) { b.handler().flush(); },
+                 +[](const Book& b) -> uint64_t { return b.handler().published(); });
+    }
+
+    {
+        using Book = BasicOrderBook<DepthPublisher<10>>;
+        SeqlockDepth<10> depth;
+        Book book{DepthPublisher<10>(&depth)};
+        run_case("depth10 publisher", flow, BATCH, book, [](auto&) {},
+                 +[](const Book& b) -> uint64_t { return b.handler().published(); });
+    }
+
+    return 0;
+}
@@ -0,0 +1,119 @@
+// Cancel-heavy workloads against each order-id index backend
+//
+// Each step adds one order and cancels one (plus a cancel miss every fifth
+// step), holding the live set steady. Dense ids are monotonic like venue
+// sequence numbers; sparse ids are random 64-bit values.
+//
+// Usage: ./bench_order_index [steps]
+
+#include "../include/OrderIndex.h"
+#include "bench_util.h"
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+using namespace bench;
+
+// std::unordered_map behind the common index interface (previous backend)
+class UnorderedMapIndex {
+private:
+    std::unordered_map<OrderId, Order*> map_;
+
+public:
+    Order* find(OrderId id) const {
+        auto it = map_.find(id);
+        return it != map_.end() ? it->second : nullptr;
+    }
+    void insert(OrderId id, Order* order) { map_[id] = order; }
+    Order* extract(OrderId id) {
+        auto it = map_.find(id);
+        if (it == map_.end()) return nullptr;
+        Order* order = it->second;
+        map_.erase(it);
+        return order;
+    }
+    size_t size() const { return map_.size(); }
+};
+
+template <typename Index>
+double run_workload(Index& index, size_t live, size_t steps, bool dense) {
+    static Order dummy;
+    Rng rng;
+    std::vector<OrderId> ids;
+    ids.reserve(live);
+    OrderId next_id = 1;
+    auto make_id = [&] { return dense ? next_id++ : (rng.next() | 1); };
+
+    for (size_t i = 0; i < live; ++i) {
+        OrderId id = make_id();
+        index.insert(id, &dummy);
+        ids.push_back(id);
+    }
+
+    size_t ops = 0;
+    double ns = time_ns_per_op(1, [&] {
+        int64_t hits = 0;
+        for (size_t step = 0; step < steps; ++step) {
+            OrderId id = make_id();
+            index.insert(id, &dummy);
+
+            // Cancel a random live order; its slot takes the new id
+            size_t k = rng.next() % ids.size();
+            hits += index.extract(ids[k]) != nullptr;
+            ids[k] = id;
+            ops += 2;
+
+            if (step % 5 == 0) {
+                // Cancel miss: far-future dense id / even sparse id (never live)
+                OrderId miss = dense ? id + (OrderId(1) << 40) : (rng.next() & ~OrderId(1));
+                hits += index.extract(miss) != nullptr;
+                ops++;
+            }
+        }
+        g_sink = hits;
+    });
+    return ns / ops;
+}
+
+template <typename Factory>
+void run_backend(const std::string& name, size_t live, size_t steps, Factory make_index) {
+    auto dense_index = make_index();
+    double dense = run_workload(dense_index, live, steps, true);
+    auto sparse_index = make_index();
+    double sparse = run_workload(sparse_index, live, steps, false);
+
+    std::cout << std::left << std::setw(10) << live
+              << std::setw(18) << name
+              << std::right << std::fixed << std::setprecision(1)
+              << std::setw(12) << dense
+              << std::setw(12) << sparse << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    size_t steps = 2'000'000;
+    if (argc > 1) {
+        steps = std::strtoull(argv[1], nullptr, 10);
+        if (steps == 0) steps = 2'000'000;
+    }
+
+    std::cout << "=== Order-id index, cancel-heavy (ns/op) ===" << std::endl;
+    std::cout << std::left << std::setw(10) << "live"
+              << std::setw(18) << "backend"
+              << std::right << std::setw(12) << "dense"
+              << std::setw(12) << "sparse" << std::endl;
+
+    for (size_t live : {size_t(10'000), size_t(100'000), size_t(1'000'000)}) {
+        run_backend("unordered_map", live, steps, [] { return UnorderedMapIndex(); });
+        run_backend("flat", live, steps, [] { return FlatOrderIndex(); });
+        run_backend("window", live, steps, [] { return WindowOrderIndex(); });
+    }
+
+    return 0;
+}
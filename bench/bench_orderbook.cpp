@@ -0,0 +1,517 @@
+// OrderBook primitive microbenchmarks
+//
+// Each scenario runs against a book pre-built with `depth` price levels per
+// side (2 ticks apart) and `orders` resting orders per level, and times one
+// primitive in isolation:
+//   add_new_level        limit order opening a level between two live ones
+//   add_existing_level   limit order joining the back of a live level
+//   cancel_front/middle/back  cancel by queue position within its level
+//   modify_reduce        in-place size reduction (keeps queue priority)
+//   modify_reprice       Modify moving an order to another live level
+//   cancel_new_reprice   the same move as Cancel + NewLimit (new id)
+//   sweep_<K>            market order consuming K whole levels
+//   sweep_ioc_<K>        the same sweep as an IOC limit priced at level K
+//   ioc_take             IOC limit taking the best level, residual dropped
+//   limit_cancel_take    the same as GTC limit + Cancel of its residual
+//   fok_kill_<K>         FOK one lot short of K levels (checked, not traded)
+//   post_only_reject     PostOnly limit priced through the touch
+//   top_of_book          best bid/ask price and qty queries
+// Each scenario runs once per selected book build (--books): the default
+// policy (dense ladder, window id index) and/or std::map levels with the flat
+// hash index, instantiated side by side from the same BasicOrderBook core.
+// Every op is timed on its own with TSC reads (the empty-timer cost is
+// subtracted); the untimed work around it restores the book's shape, so
+// every op sees the same depth. A run is `warmup` discarded repetitions plus
+// `reps` measured ones of `ops` ops each, reported as the median and MAD
+// (median absolute deviation) of the per-repetition mean ns/op.
+//
+// Sweep scenarios run once per level count in --sweep that fits the depth,
+// so the market and IOC rows show sweep cost against levels consumed.
+//
+// Usage: ./bench_orderbook [--depth 10,100,1000] [--orders 1,10] [--sweep 1,5,20]
+//                          [--books default,map] [--reps 15] [--warmup 3] [--ops 2000]
+//                          [--json out.json]
+
+#include "../include/OrderBook.h"
+#include "bench_util.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+using namespace bench;
+// The std::map build: one tree node per level, hash index for sparse ids
+struct MapBookPolicy : DefaultBookPolicy {
+    template <Side S>
+    using book_side = MapBookSide<S>;
+    using order_index = FlatOrderIndex;
+};
+
+using DefaultBook = BasicOrderBook<NullEventHandler>;
+using MapBook = BasicOrderBook<NullEventHandler, MapBookPolicy>;
+
+struct Config {
+    std::vector<size_t> depths = {10, 100, 1000};
+    std::vector<size_t> orders = {1, 10};
+    std::vector<std::string> books = {"default", "map"};
+    std::vector<size_t> sweeps = {1, 5, 20};
+    size_t reps = 15;
+    size_t warmup = 3;
+    size_t ops = 2000;
+    std::string json;
+};
+
+struct Result {
+    std::string scenario;
+    std::string book;
+    size_t depth;
+    size_t orders;
+    double median_ns;
+    double mad_ns;
+    double min_ns;
+};
+
+std::vector<size_t> parse_list(const char* arg) {
+    std::vector<size_t> out;
+    for (const char* p = arg; *p;) {
+        char* end;
+        size_t v = std::strtoull(p, &end, 10);
+        if (end == p) break;
+        if (v > 0) out.push_back(v);
+        p = (*end == ',') ? end + 1 : end;
+    }
+    return out;
+}
+
+std::vector<std::string> parse_names(const char* arg) {
+    std::vector<std::string> out;
+    for (const char* p = arg; *p;) {
+        const char* comma = std::strchr(p, ',');
+        size_t len = comma ? static_cast<size_t>(comma - p) : std::strlen(p);
+        if (len > 0) out.emplace_back(p, len);
+        p = comma ? comma + 1 : p + len;
+    }
+    return out;
+}
+
+ALWAYS_INLINE uint64_t ticks() noexcept { return clock_now<ClockSource::Tsc>(); }
+
+// Median of back-to-back timer reads, subtracted from every timed op
+uint64_t timer_overhead_ticks() {
+    std::vector<uint64_t> samples(10000);
+    for (uint64_t& s : samples) {
+        uint64_t t0 = ticks();
+        clobber_memory();
+        s = ticks() - t0;
+    }
+    std::nth_element(samples.begin(), samples.begin() + samples.size() / 2, samples.end());
+    return samples[samples.size() / 2];
+}
+
+double median(std::vector<double> v) {
+    std::nth_element(v.begin(), v.begin() + v.size() / 2, v.end());
+    return v[v.size() / 2];
+}
+
+// Price grid and message helpers shared by every book build
+struct BookShape {
+    static constexpr Price MID = 100000;
+    static constexpr Price GAP = 2;
+    static constexpr Quantity QTY = 10;
+
+    static Price price(Side side, size_t level) noexcept {
+        Price offset = 1 + GAP * static_cast<Price>(level);
+        return side == Side::Buy ? MID - offset : MID + offset;
+    }
+
+    static Msg msg(MsgType type, Side side, OrderId id, Price price, Quantity qty,
+                   TimeInForce tif = TimeInForce::GTC) noexcept {
+        Msg m{};
+        m.type = type;
+        m.side = side;
+        m.tif = tif;
+        m.id = id;
+        m.price = price;
+        m.qty = qty;
+        return m;
+    }
+};
+
+// A book of depth x orders resting orders per side, mirrored by per-level
+// id queues so ops can target a queue position and restore it afterwards
+template <typename Book>
+class Fixture : public BookShape {
+public:
+    Book book;
+    std::vector<std::deque<OrderId>> bids;   // [level] ids, front = oldest
+    std::vector<std::deque<OrderId>> asks;
+    size_t depth;
+    size_t orders;
+    OrderId next_id = 1;
+    Rng rng;
+
+    Fixture(size_t depth_, size_t orders_) : bids(depth_), asks(depth_), depth(depth_), orders(orders_) {
+        for (size_t l = 0; l < depth; ++l) {
+            for (size_t k = 0; k < orders; ++k) {
+                bids[l].push_back(add(Side::Buy, price(Side::Buy, l)));
+                asks[l].push_back(add(Side::Sell, price(Side::Sell, l)));
+            }
+        }
+    }
+
+    OrderId add(Side side, Price p) {
+        OrderId id = next_id++;
+        book.process_message(msg(MsgType::NewLimit, side, id, p, QTY));
+        return id;
+    }
+
+    void cancel(OrderId id) { book.process_message(msg(MsgType::Cancel, Side::Buy, id, 0, 0)); }
+
+    Side random_side() noexcept { return (rng.next() & 1) ? Side::Buy : Side::Sell; }
+    size_t random_level() noexcept { return rng.next() % depth; }
+    std::vector<std::deque<OrderId>>& levels(Side side) noexcept { return side == Side::Buy ? bids : asks; }
+};
+
+// Per-repetition mean ns/op of op(fixture), which returns the ticks of its
+// timed part; each scenario starts from a freshly built book
+template <typename Book, typename Op>
+std::vector<double> run_scenario(const Config& cfg, size_t depth, size_t orders, uint64_t overhead,
+                                 double ticks_per_ns, Op&& op) {
+    Fixture<Book> fx(depth, orders);
+    std::vector<double> rep_ns;
+    for (size_t rep = 0; rep < cfg.warmup + cfg.reps; ++rep) {
+        uint64_t total = 0;
+        for (size_t i = 0; i < cfg.ops; ++i) {
+            uint64_t elapsed = op(fx);
+            total += elapsed > overhead ? elapsed - overhead : 0;
+        }
+        if (rep >= cfg.warmup) rep_ns.push_back(total / ticks_per_ns / cfg.ops);
+    }
+    g_sink = static_cast<int64_t>(fx.book.get_total_messages());
+    return rep_ns;
+}
+
+// Cancel the order at queue position pos (clamped to the back) of a random
+// level, then rest a replacement at the back of the same level
+uint64_t cancel_at(auto& fx, size_t pos) {
+    Side side = fx.random_side();
+    size_t level = fx.random_level();
+    std::deque<OrderId>& q = fx.levels(side)[level];
+    size_t k = std::min(pos, q.size() - 1);
+    OrderId id = q[k];
+
+    uint64_t t0 = ticks();
+    fx.cancel(id);
+    uint64_t t1 = ticks();
+
+    q.erase(q.begin() + static_cast<ptrdiff_t>(k));
+    q.push_back(fx.add(side, BookShape::price(side, level)));
+    return t1 - t0;
+}
+
+// Modify shrinking a random resting order by one lot where it sits; orders
+// down to one lot are first topped up again (untimed, re-queued)
+uint64_t modify_reduce(auto& fx) {
+    Side side = fx.random_side();
+    size_t level = fx.random_level();
+    std::deque<OrderId>& q = fx.levels(side)[level];
+    size_t k = fx.rng.next() % q.size();
+    OrderId id = q[k];
+    Price p = BookShape::price(side, level);
+    if (fx.book.find_order(id)->qty <= 1) {
+        fx.book.process_message(BookShape::msg(MsgType::Modify, side, id, p, BookShape::QTY));
+        q.erase(q.begin() + static_cast<ptrdiff_t>(k));
+        q.push_back(id);
+    }
+    Msg m = BookShape::msg(MsgType::Modify, side, id, p, fx.book.find_order(id)->qty - 1);
+
+    uint64_t t0 = ticks();
+    fx.book.process_message(m);
+    return ticks() - t0;
+}
+
+// Quote update: a random resting order moves to another live level of its
+// side, as one Modify (same id and pool slot) or as Cancel + NewLimit; the
+// oldest order of the target level then moves back (untimed) to keep the
+// book's shape
+uint64_t reprice(auto& fx, bool amend) {
+    Side side = fx.random_side();
+    size_t from = fx.random_level();
+    size_t to = (from + 1 + fx.rng.next() % (fx.depth - 1)) % fx.depth;
+    std::deque<OrderId>& q = fx.levels(side)[from];
+    size_t k = fx.rng.next() % q.size();
+    OrderId id = q[k];
+    Price p = BookShape::price(side, to);
+
+    uint64_t t0, t1;
+    if (amend) {
+        Msg m = BookShape::msg(MsgType::Modify, side, id, p, BookShape::QTY);
+        t0 = ticks();
+        fx.book.process_message(m);
+        t1 = ticks();
+    } else {
+        Msg c = BookShape::msg(MsgType::Cancel, side, id, 0, 0);
+        id = fx.next_id++;
+        Msg n = BookShape::msg(MsgType::NewLimit, side, id, p, BookShape::QTY);
+        t0 = ticks();
+        fx.book.process_message(c);
+        fx.book.process_message(n);
+        t1 = ticks();
+    }
+
+    std::deque<OrderId>& dest = fx.levels(side)[to];
+    q.erase(q.begin() + static_cast<ptrdiff_t>(k));
+    dest.push_back(id);
+    OrderId back = dest.front();
+    fx.book.process_message(BookShape::msg(MsgType::Modify, side, back, BookShape::price(side, from), BookShape::QTY));
+    dest.pop_front();
+    q.push_back(back);
+    return t1 - t0;
+}
+
+// Limit order resting on a price level chosen by price_of(side, level),
+// cancelled again afterwards
+template <typename PriceOf>
+uint64_t add_and_remove(auto& fx, PriceOf&& price_of) {
+    Side side = fx.random_side();
+    Msg m = BookShape::msg(MsgType::NewLimit, side, fx.next_id++, price_of(side, fx.random_level()), BookShape::QTY);
+
+    uint64_t t0 = ticks();
+    fx.book.process_message(m);
+    uint64_t t1 = ticks();
+
+    fx.cancel(m.id);
+    return t1 - t0;
+}
+
+// Order consuming exactly the best k levels of a side, which are then
+// rebuilt: a market order, or an IOC limit priced at the k-th level (both
+// run the same matching kernel, so the rows should agree)
+uint64_t sweep(auto& fx, size_t k, bool market) {
+    Side side = fx.random_side();
+    Side resting = side == Side::Buy ? Side::Sell : Side::Buy;
+    Quantity qty = static_cast<Quantity>(k * fx.orders) * BookShape::QTY;
+    Msg m = market ? BookShape::msg(MsgType::NewMarket, side, fx.next_id++, 0, qty)
+                   : BookShape::msg(MsgType::NewLimit, side, fx.next_id++, BookShape::price(resting, k - 1), qty,
+                                    TimeInForce::IOC);
+
+    uint64_t t0 = ticks();
+    fx.book.process_message(m);
+    uint64_t t1 = ticks();
+
+    for (size_t l = 0; l < k; ++l) {
+        std::deque<OrderId>& q = fx.levels(resting)[l];
+        q.clear();
+        for (size_t n = 0; n < fx.orders; ++n) q.push_back(fx.add(resting, BookShape::price(resting, l)));
+    }
+    return t1 - t0;
+}
+
+// Limit order taking the whole best level of the other side with one level's
+// worth to spare: as one IOC (residual dropped inside the book) or as the
+// GTC limit + Cancel a client emulating IOC would send; the level is then
+// rebuilt
+uint64_t take_level(auto& fx, bool ioc) {
+    Side side = fx.random_side();
+    Side resting = side == Side::Buy ? Side::Sell : Side::Buy;
+    Quantity qty = static_cast<Quantity>(2 * fx.orders) * BookShape::QTY;
+    Msg m = BookShape::msg(MsgType::NewLimit, side, fx.next_id++, BookShape::price(resting, 0), qty,
+                         ioc ? TimeInForce::IOC : TimeInForce::GTC);
+    Msg c = BookShape::msg(MsgType::Cancel, side, m.id, 0, 0);
+
+    uint64_t t0 = ticks();
+    fx.book.process_message(m);
+    if (!ioc) fx.book.process_message(c);
+    uint64_t t1 = ticks();
+
+    std::deque<OrderId>& q = fx.levels(resting)[0];
+    q.clear();
+    for (size_t n = 0; n < fx.orders; ++n) q.push_back(fx.add(resting, BookShape::price(resting, 0)));
+    return t1 - t0;
+}
+
+// FOK priced through the best k levels but one lot larger than they hold:
+// rejected by the up-front quantity walk, so the book is left as it was
+uint64_t fok_kill(auto& fx, size_t k) {
+    Side side = fx.random_side();
+    Side resting = side == Side::Buy ? Side::Sell : Side::Buy;
+    Quantity qty = static_cast<Quantity>(k * fx.orders) * BookShape::QTY + 1;
+    Msg m = BookShape::msg(MsgType::NewLimit, side, fx.next_id++, BookShape::price(resting, k - 1), qty,
+                         TimeInForce::FOK);
+
+    uint64_t t0 = ticks();
+    fx.book.process_message(m);
+    return ticks() - t0;
+}
+
+// PostOnly priced at the other side's best price: rejected before matching
+uint64_t post_only_reject(auto& fx) {
+    Side side = fx.random_side();
+    Side resting = side == Side::Buy ? Side::Sell : Side::Buy;
+    Msg m = BookShape::msg(MsgType::NewLimit, side, fx.next_id++, BookShape::price(resting, 0), BookShape::QTY,
+                         TimeInForce::PostOnly);
+
+    uint64_t t0 = ticks();
+    fx.book.process_message(m);
+    return ticks() - t0;
+}
+
+// Best price and qty on both sides, 16 queries per timed op
+uint64_t top_of_book(auto& fx) {
+    int64_t acc = 0;
+    uint64_t t0 = ticks();
+    for (int n = 0; n < 4; ++n) {
+        acc += fx.book.best_bid() + fx.book.best_ask() + fx.book.best_bid_qty() + fx.book.best_ask_qty();
+        clobber_memory();
+    }
+    uint64_t t1 = ticks();
+    g_sink = acc;
+    return t1 - t0;
+}
+
+Result summarize(const std::string& scenario, const std::string& book, size_t depth, size_t orders,
+                 std::vector<double> rep_ns, double per_op_divisor = 1.0) {
+    for (double& v : rep_ns) v /= per_op_divisor;
+    double med = median(rep_ns);
+    std::vector<double> dev;
+    for (double v : rep_ns) dev.push_back(std::fabs(v - med));
+    return {scenario, book, depth, orders, med, median(dev), *std::min_element(rep_ns.begin(), rep_ns.end())};
+}
+
+void write_json(const Config& cfg, double ticks_per_ns, double overhead_ns, const std::vector<Result>& results) {
+    std::ofstream out(cfg.json);
+    if (!out.is_open()) {
+        std::cerr << "Warning: Could not write results to " << cfg.json << std::endl;
+        return;
+    }
+    out << std::fixed << std::setprecision(2);
+    out << "{\n";
+    out << "  \"benchmark\": \"bench_orderbook\",\n";
+    out << "  \"config\": {\"reps\": " << cfg.reps << ", \"warmup\": " << cfg.warmup
+        << ", \"ops\": " << cfg.ops << ", \"sweep_levels\": [";
+    for (size_t i = 0; i < cfg.sweeps.size(); ++i) out << (i ? ", " : "") << cfg.sweeps[i];
+    out << "]},\n";
+    out << "  \"clock\": {\"source\": \"tsc\", \"ticks_per_ns\": " << std::setprecision(4) << ticks_per_ns
+        << ", \"timer_overhead_ns\": " << overhead_ns << "},\n" << std::setprecision(2);
+    out << "  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        out << "    {\"scenario\": \"" << r.scenario << "\", \"book\": \"" << r.book
+            << "\", \"depth\": " << r.depth
+            << ", \"orders_per_level\": " << r.orders << ", \"median_ns\": " << r.median_ns
+            << ", \"mad_ns\": " << r.mad_ns << ", \"min_ns\": " << r.min_ns << "}"
+            << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    out << "  ]\n";
+    out << "}\n";
+    std::cout << "\nResults written to: " << cfg.json << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    Config cfg;
+    bool bad_arg = false;   // unknown option, or an option missing its value
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--depth") == 0 && i + 1 < argc) {
+            cfg.depths = parse_list(argv[++i]);
+        } else if (strcmp(argv[i], "--orders") == 0 && i + 1 < argc) {
+            cfg.orders = parse_list(argv[++i]);
+        } else if (strcmp(argv[i], "--sweep") == 0 && i + 1 < argc) {
+            cfg.sweeps = parse_list(argv[++i]);
+        } else if (strcmp(argv[i], "--reps") == 0 && i + 1 < argc) {
+            cfg.reps = std::strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--warmup") == 0 && i + 1 < argc) {
+            cfg.warmup = std::strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--ops") == 0 && i + 1 < argc) {
+            cfg.ops = std::strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--books") == 0 && i + 1 < argc) {
+            cfg.books = parse_names(argv[++i]);
+        } else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            cfg.json = argv[++i];
+        } else {
+            bad_arg = true;
+        }
+    }
+    bool books_ok = !cfg.books.empty();
+    for (const std::string& b : cfg.books) books_ok = books_ok && (b == "default" || b == "map");
+    if (bad_arg || cfg.depths.empty() || cfg.orders.empty() || cfg.reps == 0 || cfg.ops == 0 || cfg.sweeps.empty() ||
+        !books_ok) {
+        std::cerr << "Usage: " << argv[0] << " [--depth 10,100,1000] [--orders 1,10] [--sweep 1,5,20]"
+                  << " [--books default,map] [--reps <n>] [--warmup <n>] [--ops <n>] [--json <file>]"
+                  << std::endl;
+        return 1;
+    }
+
+    double ticks_per_ns = tsc_ticks_per_ns();
+    uint64_t overhead = timer_overhead_ticks();
+    double overhead_ns = overhead / ticks_per_ns;
+
+    std::cout << "=== OrderBook primitives (ns/op, median of " << cfg.reps << " reps x " << cfg.ops
+              << " ops, after " << cfg.warmup << " warmup) ===" << std::endl;
+    std::cout << "timer overhead " << std::fixed << std::setprecision(1) << overhead_ns
+              << " ns (subtracted), TSC " << std::setprecision(3) << ticks_per_ns << " ticks/ns\n" << std::endl;
+    std::cout << std::left << std::setw(20) << "scenario" << std::setw(9) << "book" << std::right
+              << std::setw(7) << "depth"
+              << std::setw(8) << "orders" << std::setw(10) << "median" << std::setw(8) << "MAD"
+              << std::setw(10) << "min" << std::endl;
+
+    std::vector<Result> results;
+    for (size_t depth : cfg.depths) {
+        for (size_t orders : cfg.orders) {
+            // One row per selected book build
+            auto run = [&](const std::string& name, auto&& op, double per_op_divisor = 1.0) {
+                for (const std::string& book : cfg.books) {
+                    std::vector<double> rep_ns =
+                        book == "map" ? run_scenario<MapBook>(cfg, depth, orders, overhead, ticks_per_ns, op)
+                                      : run_scenario<DefaultBook>(cfg, depth, orders, overhead, ticks_per_ns, op);
+                    Result r = summarize(name, book, depth, orders, std::move(rep_ns), per_op_divisor);
+                    std::cout << std::left << std::setw(20) << r.scenario << std::setw(9) << r.book << std::right
+                              << std::setw(7) << depth << std::setw(8) << orders << std::setprecision(1)
+                              << std::setw(10) << r.median_ns << std::setw(8) << r.mad_ns << std::setw(10)
+                              << r.min_ns << std::endl;
+                    results.push_back(r);
+                }
+            };
+
+            // Odd offsets from a level are free (levels are GAP = 2 apart)
+            run("add_new_level", [](auto& fx) {
+                return add_and_remove(fx, [](Side side, size_t level) {
+                    return BookShape::price(side, level) + (side == Side::Buy ? -1 : 1);
+                });
+            });
+            run("add_existing_level", [](auto& fx) {
+                return add_and_remove(fx, [](Side side, size_t level) { return BookShape::price(side, level); });
+            });
+            run("cancel_front", [](auto& fx) { return cancel_at(fx, 0); });
+            run("cancel_middle", [orders](auto& fx) { return cancel_at(fx, orders / 2); });
+            run("cancel_back", [orders](auto& fx) { return cancel_at(fx, orders - 1); });
+            run("modify_reduce", [](auto& fx) { return modify_reduce(fx); });
+            if (depth > 1) {
+                run("modify_reprice", [](auto& fx) { return reprice(fx, true); });
+                run("cancel_new_reprice", [](auto& fx) { return reprice(fx, false); });
+            }
+            for (size_t k : cfg.sweeps) {
+                if (k > depth) continue;
+                run("sweep_" + std::to_string(k), [k](auto& fx) { return sweep(fx, k, true); });
+                run("sweep_ioc_" + std::to_string(k), [k](auto& fx) { return sweep(fx, k, false); });
+                run("fok_kill_" + std::to_string(k), [k](auto& fx) { return fok_kill(fx, k); });
+            }
+            run("ioc_take", [](auto& fx) { return take_level(fx, true); });
+            run("limit_cancel_take", [](auto& fx) { return take_level(fx, false); });
+            run("post_only_reject", [](auto& fx) { return post_only_reject(fx); });
+            run("top_of_book", [](auto& fx) { return top_of_book(fx); }, 16.0);
+        }
+    }
+
+    if (!cfg.json.empty()) write_json(cfg, ticks_per_ns, overhead_ns, results);
+    return 0;
+}
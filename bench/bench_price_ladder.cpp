@@ -0,0 +1,126 @@
+// Price ladder vs std::map side structure at 500 / 5k / 50k live levels
+//
+// Usage: ./bench_price_ladder [ops_per_case]
+
+#include "../include/PriceLadder.h"
+#include "bench_util.h"
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+using namespace bench;
+
+// Side structure with `levels` live prices starting at `base`, one tick apart
+template <typename Book>
+void prefill(Book& book, Price base, size_t levels) {
+    for (size_t i = 0; i < levels; ++i) {
+        book.get_or_create(base + static_cast<Price>(i));
+    }
+}
+
+// Inside churn: the best level empties and a new one appears one tick
+// either side of it (random walk of the touch, depth stays constant)
+template <typename Book>
+double bench_touch_churn(Book& book, size_t ops) {
+    return time_ns_per_op(ops, [&] {
+        Rng rng;
+        for (size_t i = 0; i < ops; ++i) {
+            Price best = book.best_price();
+            book.erase(best);
+            Price p = best + static_cast<Price>(rng.next() % 3) - 1;
+            if (book.find(p) != nullptr) {
+                p = best;
+            }
+            book.get_or_create(p);
+        }
+    });
+}
+
+// Random insert/erase across the live range (depth stays around `levels`)
+template <typename Book>
+double bench_random_churn(Book& book, Price base, size_t levels, size_t ops) {
+    return time_ns_per_op(ops, [&] {
+        Rng rng;
+        for (size_t i = 0; i < ops; ++i) {
+            Price p = base + static_cast<Price>(rng.next() % (2 * levels));
+            if (book.find(p) != nullptr) {
+                book.erase(p);
+            } else {
+                book.get_or_create(p);
+            }
+        }
+    });
+}
+
+// Top-of-book query
+template <typename Book>
+double bench_best_query(Book& book, size_t ops) {
+    return time_ns_per_op(ops, [&] {
+        int64_t acc = 0;
+        for (size_t i = 0; i < ops; ++i) {
+            acc += book.best_price() + book.best_level().total_qty();
+            clobber_memory();
+        }
+        g_sink = acc;
+    });
+}
+
+template <typename Factory>
+void run_backend(const std::string& name, size_t levels, size_t ops, Factory make_book) {
+    using Book = decltype(make_book());
+    const Price base = 100000;
+
+    Book churn = make_book();
+    prefill(churn, base, levels);
+    double touch = bench_touch_churn(churn, ops);
+
+    Book random = make_book();
+    prefill(random, base, levels);
+    double rnd = bench_random_churn(random, base, levels, ops);
+
+    Book query = make_book();
+    prefill(query, base, levels);
+    double best = bench_best_query(query, ops);
+
+    std::cout << std::left << std::setw(10) << levels
+              << std::setw(14) << name
+              << std::right << std::fixed << std::setprecision(1)
+              << std::setw(14) << touch
+              << std::setw(14) << rnd
+              << std::setw(14) << best << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    size_t ops = 2'000'000;
+    if (argc > 1) {
+        ops = std::strtoull(argv[1], nullptr, 10);
+        if (ops == 0) ops = 2'000'000;
+    }
+
+    std::cout << "=== Price ladder vs std::map (ask side, ns/op) ===" << std::endl;
+    std::cout << std::left << std::setw(10) << "levels"
+              << std::setw(14) << "backend"
+              << std::right
+              << std::setw(14) << "touch_churn"
+              << std::setw(14) << "random_churn"
+              << std::setw(14) << "best_query" << std::endl;
+
+    for (size_t levels : {size_t(500), size_t(5'000), size_t(50'000)}) {
+        // Window covers the whole random-churn range (2 x levels)
+        size_t window = 4 * levels;
+        run_backend("std::map", levels, ops,
+            [] { return MapBookSide<Side::Sell>(); });
+        run_backend("ladder", levels, ops,
+            [window] { return PriceLadder<Side::Sell>(window); });
+        run_backend("ladder/4096", levels, ops,
+            [] { return PriceLadder<Side::Sell>(); });
+    }
+
+    return 0;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+// Shared helpers for the microbenchmarks in bench/
+
+#include <chrono>
+#include <cstdint>
+
+namespace bench {
+
+inline volatile int64_t g_sink = 0;
+
+// Keep the optimizer from hoisting loop-invariant reads out of a bench loop
+inline void clobber_memory() {
+#ifdef __GNUC__
+    asm volatile("" : : : "memory");
+#endif
+}
+
+// Fast deterministic RNG (same xorshift family as generate_dataset)
+struct Rng {
+    uint64_t s = 0x9E3779B97F4A7C15ULL;
+    uint64_t next() {
+        s ^= s << 13;
+        s ^= s >> 7;
+        s ^= s << 17;
+        return s;
+    }
+};
+
+template <typename F>
+double time_ns_per_op(size_t ops, F&& f) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / ops;
+}
+
+}  // namespace bench
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include "Message.h"
+#include "MappedFile.h"
+
+// Fixed-width little-endian message file:
+//   BinaryFileHeader (64 bytes) followed by msg_count BinaryMsgRecords.
+// Records are read in place from a mapping, so the layout is the on-disk
+// format; hosts are required to be little-endian.
+static_assert(std::endian::native == std::endian::little,
+              "binary message format is little-endian");
+
+static constexpr char BINARY_MAGIC[8] = {'L', 'O', 'B', 'M', 'S', 'G', 'S', '\0'};
+static constexpr uint32_t BINARY_VERSION = 1;
+
+struct BinaryFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t record_size;     // sizeof(BinaryMsgRecord) at write time
+    uint64_t msg_count;
+    // Instrument metadata
+    char symbol[16];          // NUL-padded
+    int64_t tick_size;        // price units per tick
+    int64_t lot_size;         // quantity units per lot
+    uint64_t reserved;
+};
+static_assert(sizeof(BinaryFileHeader) == 64, "header layout is part of the format");
+
+struct BinaryMsgRecord {
+    uint64_t ts_ns;           // exchange timestamp from the source
+    uint64_t id;
+    int64_t  price;
+    int64_t  qty;
+    uint8_t  type;            // MsgType
+    uint8_t  side;            // Side
+    uint16_t flags;           // bits 0-1 TimeInForce (0 = GTC, so older files
+                              // read as GTC); other bits reserved, 0
+    uint32_t symbol;          // instrument id (0 in single-symbol files)
+};
+static_assert(sizeof(BinaryMsgRecord) == 40, "record layout is part of the format");
+
+inline BinaryMsgRecord to_binary_record(const Msg& msg) {
+    BinaryMsgRecord rec{};
+    rec.ts_ns = msg.ts_ns;
+    rec.id = msg.id;
+    rec.price = msg.price;
+    rec.qty = msg.qty;
+    rec.type = static_cast<uint8_t>(msg.type);
+    rec.side = static_cast<uint8_t>(msg.side);
+    rec.flags = static_cast<uint16_t>(msg.tif);
+    rec.symbol = msg.symbol;
+    return rec;
+}
+
+// A record to_msg() can decode: a known type and side, and no reserved
+// flag bits set. Readers check this before decoding, as the CSV reader
+// checks a line's fields.
+inline bool is_valid_record(const BinaryMsgRecord& rec) noexcept {
+    return rec.type < MSG_TYPES && rec.side <= static_cast<uint8_t>(Side::Sell) && (rec.flags & ~0x3) == 0;
+}
+
+inline void to_msg(const BinaryMsgRecord& rec, Msg& msg) {
+    msg.type = static_cast<MsgType>(rec.type);
+    msg.side = static_cast<Side>(rec.side);
+    msg.tif = static_cast<TimeInForce>(rec.flags & 0x3);
+    msg.symbol = rec.symbol;
+    msg.ts_ns = rec.ts_ns;
+    msg.id = rec.id;
+    msg.price = rec.price;
+    msg.qty = rec.qty;
+}
+
+// Maps a binary message file and exposes its records in place. Every
+// record is checked on open (is_valid_record); one bad record rejects the
+// file.
+class BinaryMessageFile {
+private:
+    MappedFile file_;
+    const BinaryFileHeader* header_ = nullptr;
+    const BinaryMsgRecord* records_ = nullptr;
+    std::string error_;
+
+public:
+    explicit BinaryMessageFile(const std::string& path) : file_(path) {
+        if (!file_.is_open()) {
+            error_ = "could not open " + path;
+            return;
+        }
+        if (file_.size() < sizeof(BinaryFileHeader)) {
+            error_ = "file too small for header";
+            return;
+        }
+        const auto* header = reinterpret_cast<const BinaryFileHeader*>(file_.data());
+        if (std::memcmp(header->magic, BINARY_MAGIC, sizeof(BINARY_MAGIC)) != 0) {
+            error_ = "bad magic (not a binary message file)";
+            return;
+        }
+        if (header->version != BINARY_VERSION || header->record_size != sizeof(BinaryMsgRecord)) {
+            error_ = "unsupported version " + std::to_string(header->version);
+            return;
+        }
+        if (header->msg_count > (file_.size() - sizeof(BinaryFileHeader)) / sizeof(BinaryMsgRecord)) {
+            error_ = "truncated file (header claims " + std::to_string(header->msg_count) + " records)";
+            return;
+        }
+        const auto* records = reinterpret_cast<const BinaryMsgRecord*>(file_.data() + sizeof(BinaryFileHeader));
+        for (uint64_t i = 0; i < header->msg_count; ++i) {
+            if (!is_valid_record(records[i])) {
+                error_ = "invalid record " + std::to_string(i) + " (type " + std::to_string(records[i].type) +
+                         ", side " + std::to_string(records[i].side) + ", flags " + std::to_string(records[i].flags) + ")";
+                return;
+            }
+        }
+        header_ = header;
+        records_ = records;
+    }
+
+    bool is_valid() const noexcept { return header_ != nullptr; }
+    const std::string& error() const noexcept { return error_; }
+
+    const BinaryFileHeader& header() const noexcept { return *header_; }
+    size_t size() const noexcept { return header_ ? header_->msg_count : 0; }
+    const BinaryMsgRecord* begin() const noexcept { return records_; }
+    const BinaryMsgRecord* end() const noexcept { return records_ + size(); }
+    const BinaryMsgRecord& operator[](size_t i) const noexcept { return records_[i]; }
+};
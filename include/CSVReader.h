@@ -7,10 +7,56 @@
 
 class CSVReader {
 public:
+    enum class LineStatus {
+        Message,    // msg filled in
+        Skip,       // blank line or # comment
+        Malformed   // header row, missing field or bad number (incl. out of range)
+    };
+    
+    // Stream-based reader (getline + istringstream, portable reference)
     static std::vector<Msg> read_messages(const std::string& filename);
     
+    // Zero-copy reader: mmaps the file and parses fields in place, appending
+    // to a vector reserved for the file's line count (no per-line strings or
+    // streams)
+    static std::vector<Msg> read_messages_mmap(const std::string& filename);
+    
+    // Parse one "ts_ns,MsgType,Side,OrderId,Price,Qty[,Symbol[,Tif]]" line
+    // starting at p and advance p past its newline (Symbol defaults to 0, Tif
+    // - GTC / IOC / FOK / PostOnly - to GTC)
+    static LineStatus parse_line(const char*& p, const char* end, Msg& msg);
+    
 private:
     static MsgType parse_msg_type(const std::string& s);
     static Side parse_side(const std::string& s);
+    static TimeInForce parse_tif(const std::string& s);
 };
 
+// Incremental CSV reader for inputs that do not fit in memory: lines are
+// parsed out of one fixed-size read buffer, so memory stays bounded by the
+// buffer regardless of file length
+class CSVStreamReader {
+public:
+    static constexpr size_t DEFAULT_BUFFER_BYTES = 4 * 1024 * 1024;
+    
+    explicit CSVStreamReader(const std::string& filename, size_t buffer_bytes = DEFAULT_BUFFER_BYTES);
+    
+    bool is_open() const { return file_.is_open(); }
+    
+    // Parse up to max messages into out; returns 0 at end of input
+    size_t next_batch(Msg* out, size_t max);
+    
+    size_t malformed() const { return malformed_; }
+    
+private:
+    std::ifstream file_;
+    std::vector<char> buffer_;
+    size_t begin_;      // first unparsed byte
+    size_t limit_;      // one past the last complete line
+    size_t end_;        // one past the last byte read
+    bool eof_;
+    bool first_line_;
+    size_t malformed_;
+    
+    bool refill();
+};
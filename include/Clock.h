@@ -0,0 +1,60 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include "PriceLevel.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// Engine-side clock used to stamp matches (Trade::match_ts). Event time
+// always comes from the input (Msg::ts_ns); this clock only measures when
+// the engine got to a message, so it is a compile-time choice:
+//   None    no clock read, match_ts = 0 (default)
+//   Tsc     raw time-stamp counter ticks (rdtsc; steady_clock elsewhere)
+//   Steady  std::chrono::steady_clock nanoseconds
+enum class ClockSource : uint8_t {
+    None,
+    Tsc,
+    Steady
+};
+
+template <ClockSource C>
+ALWAYS_INLINE uint64_t clock_now() noexcept {
+    if constexpr (C == ClockSource::None) {
+        return 0;
+    } else if constexpr (C == ClockSource::Tsc) {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return clock_now<ClockSource::Steady>();
+#endif
+    } else {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+}
+
+// TSC ticks per nanosecond, measured once against steady_clock (~10 ms on
+// first use); 1.0 where clock_now<Tsc> already falls back to steady_clock.
+// Assumes an invariant TSC (constant rate across cores and power states).
+inline double tsc_ticks_per_ns() {
+    static const double ratio = [] {
+#if defined(__x86_64__) || defined(__i386__)
+        uint64_t ns0 = clock_now<ClockSource::Steady>();
+        uint64_t tsc0 = clock_now<ClockSource::Tsc>();
+        uint64_t ns1 = ns0;
+        while (ns1 - ns0 < 10'000'000) {
+            std::this_thread::yield();
+            ns1 = clock_now<ClockSource::Steady>();
+        }
+        uint64_t tsc1 = clock_now<ClockSource::Tsc>();
+        return static_cast<double>(tsc1 - tsc0) / static_cast<double>(ns1 - ns0);
+#else
+        return 1.0;
+#endif
+    }();
+    return ratio;
+}
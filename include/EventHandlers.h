@@ -0,0 +1,254 @@
+#pragma once
+
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "PriceLevel.h"
+#include "Trade.h"
+#include "MarketData.h"
+
+// Event-handler policies for BasicOrderBook<Handler>.
+//
+// The book calls these inline (no virtual dispatch), so a handler is any
+// type with the members below; empty bodies compile away entirely. Derive
+// from NullEventHandler to implement only some of them.
+//   on_trade(const Trade&)                 one fill against a resting order
+//   on_order_accepted(id, side, price, qty) a NewLimit/NewMarket arrives
+//   on_order_rested(const Order&)           a limit residual joins its level
+//   on_order_cancelled(const Order&)        a resting order is about to be
+//                                           cancelled (qty is the unfilled
+//                                           remainder; still on its level)
+//   on_order_killed(id, side, price, qty)   a NewLimit leaves without resting:
+//                                           IOC residual, unfillable FOK or
+//                                           crossing PostOnly (qty is what
+//                                           was dropped; never in the book)
+//   on_order_modified(id, side, price, qty, old_price, old_qty)
+//                                           a Modify/CancelReplace changed a
+//                                           resting order to price/qty (any
+//                                           fills and the re-rest follow as
+//                                           usual)
+//   on_level_update(const L2Delta&)         a level's qty/order count changed
+//                                           (once per fill, rest or cancel;
+//                                           a level a sweep takes whole
+//                                           only reports its Delete)
+//   on_message_end(const Book&)             process_message is done (the
+//                                           book is passed for queries)
+// References passed to handlers are only valid for the duration of the call.
+
+// Discards every event
+struct NullEventHandler {
+    ALWAYS_INLINE void on_trade(const Trade&) noexcept {}
+    ALWAYS_INLINE void on_order_accepted(OrderId, Side, Price, Quantity) noexcept {}
+    ALWAYS_INLINE void on_order_rested(const Order&) noexcept {}
+    ALWAYS_INLINE void on_order_cancelled(const Order&) noexcept {}
+    ALWAYS_INLINE void on_order_killed(OrderId, Side, Price, Quantity) noexcept {}
+    ALWAYS_INLINE void on_order_modified(OrderId, Side, Price, Quantity, Price, Quantity) noexcept {}
+    ALWAYS_INLINE void on_level_update(const L2Delta&) noexcept {}
+    template <typename Book>
+    ALWAYS_INLINE void on_message_end(const Book&) noexcept {}
+};
+
+// Appends every trade to a vector (the book's original behavior)
+class TradeCollector : public NullEventHandler {
+private:
+    std::vector<Trade> trades_;
+
+public:
+    explicit TradeCollector(size_t capacity = 0) { trades_.reserve(capacity); }
+
+    ALWAYS_INLINE void on_trade(const Trade& trade) { trades_.push_back(trade); }
+
+    const std::vector<Trade>& trades() const noexcept { return trades_; }
+    void reserve(size_t capacity) { trades_.reserve(capacity); }
+    void clear() noexcept { trades_.clear(); }
+};
+
+// Appends every L2 delta to a vector (a publish sink for tests and tools)
+class L2DeltaCollector : public NullEventHandler {
+private:
+    std::vector<L2Delta> deltas_;
+
+public:
+    ALWAYS_INLINE void on_level_update(const L2Delta& delta) { deltas_.push_back(delta); }
+
+    const std::vector<L2Delta>& deltas() const noexcept { return deltas_; }
+    void clear() noexcept { deltas_.clear(); }
+};
+
+enum class ConflationWindow : uint8_t {
+    Message,  // flush after every process_message
+    Batch     // caller flushes (e.g. once per batch of messages)
+};
+
+// Coalesces level deltas within a window and forwards one net delta per
+// touched level to Sink::on_level_update on flush. A level that appears and
+// empties inside one window is never published; a sweep through a level
+// publishes its final state once instead of once per fill. Levels touched in
+// a window are few, so pending entries are found by a short linear scan.
+template <typename Sink>
+class L2Conflator : public NullEventHandler {
+private:
+    struct Pending {
+        L2Delta delta;   // latest state
+        bool existed;    // level was live before the window opened
+    };
+
+    Sink sink_;
+    std::vector<Pending> pending_;
+    ConflationWindow window_;
+    uint64_t received_;
+    uint64_t published_;
+
+public:
+    explicit L2Conflator(ConflationWindow window = ConflationWindow::Message, Sink sink = Sink())
+        : sink_(std::move(sink)), window_(window), received_(0), published_(0) {
+        pending_.reserve(64);
+    }
+
+    void on_level_update(const L2Delta& delta) {
+        received_++;
+        for (auto it = pending_.rbegin(); it != pending_.rend(); ++it) {
+            if (it->delta.price == delta.price && it->delta.side == delta.side) {
+                it->delta = delta;
+                return;
+            }
+        }
+        pending_.push_back({delta, delta.action != L2Action::Add});
+    }
+
+    template <typename Book>
+    ALWAYS_INLINE void on_message_end(const Book&) {
+        if (window_ == ConflationWindow::Message && !pending_.empty()) flush();
+    }
+
+    void flush() {
+        for (const Pending& p : pending_) {
+            L2Delta out = p.delta;
+            if (out.action == L2Action::Delete) {
+                if (!p.existed) continue;  // transient level
+            } else {
+                out.action = p.existed ? L2Action::Modify : L2Action::Add;
+            }
+            sink_.on_level_update(out);
+            published_++;
+        }
+        pending_.clear();
+    }
+
+    Sink& sink() noexcept { return sink_; }
+    const Sink& sink() const noexcept { return sink_; }
+    uint64_t received() const noexcept { return received_; }    // raw deltas in
+    uint64_t published() const noexcept { return published_; }  // net deltas out
+};
+
+// Maintains a materialized top-N depth and publishes it through a
+// SeqlockDepth for other threads to poll with a memcpy. The snapshot is
+// retaken only after a message changed a level inside the published top N
+// (or the side had fewer than N levels), so deep-book churn costs one
+// comparison per delta.
+template <size_t N>
+class DepthPublisher : public NullEventHandler {
+private:
+    SeqlockDepth<N>* target_;
+    DepthSnapshot<N> depth_;   // last published (matching thread only)
+    bool dirty_;
+    uint64_t published_;
+
+    bool in_top(const L2Delta& delta) const noexcept {
+        const DepthSide<N>& side = (delta.side == Side::Buy) ? depth_.bids : depth_.asks;
+        if (side.levels < N) return true;
+        Price worst = side.prices[N - 1];
+        return (delta.side == Side::Buy) ? delta.price >= worst : delta.price <= worst;
+    }
+
+public:
+    explicit DepthPublisher(SeqlockDepth<N>* target = nullptr)
+        : target_(target), depth_{}, dirty_(false), published_(0) {}
+
+    ALWAYS_INLINE void on_level_update(const L2Delta& delta) {
+        dirty_ = dirty_ || in_top(delta);
+    }
+
+    template <typename Book>
+    void on_message_end(const Book& book) {
+        if (LIKELY(!dirty_)) return;
+        dirty_ = false;
+        DepthLevels levels = book.snapshot_depth(N, depth_.bids.buffers(), depth_.asks.buffers());
+        depth_.bids.levels = static_cast<uint32_t>(levels.bids);
+        depth_.asks.levels = static_cast<uint32_t>(levels.asks);
+        depth_.sequence = book.get_total_messages();
+        if (target_) target_->publish(depth_);
+        published_++;
+    }
+
+    const DepthSnapshot<N>& depth() const noexcept { return depth_; }
+    uint64_t published() const noexcept { return published_; }
+};
+
+// Forwards every event to two handlers in turn (e.g. trades + market data)
+template <typename First, typename Second>
+class EventFanout {
+private:
+    First first_;
+    Second second_;
+
+public:
+    explicit EventFanout(First first = First(), Second second = Second())
+        : first_(std::move(first)), second_(std::move(second)) {}
+
+    ALWAYS_INLINE void on_trade(const Trade& trade) {
+        first_.on_trade(trade);
+        second_.on_trade(trade);
+    }
+    ALWAYS_INLINE void on_order_accepted(OrderId id, Side side, Price price, Quantity qty) {
+        first_.on_order_accepted(id, side, price, qty);
+        second_.on_order_accepted(id, side, price, qty);
+    }
+    ALWAYS_INLINE void on_order_rested(const Order& order) {
+        first_.on_order_rested(order);
+        second_.on_order_rested(order);
+    }
+    ALWAYS_INLINE void on_order_cancelled(const Order& order) {
+        first_.on_order_cancelled(order);
+        second_.on_order_cancelled(order);
+    }
+    ALWAYS_INLINE void on_order_killed(OrderId id, Side side, Price price, Quantity qty) {
+        first_.on_order_killed(id, side, price, qty);
+        second_.on_order_killed(id, side, price, qty);
+    }
+    ALWAYS_INLINE void on_order_modified(OrderId id, Side side, Price price, Quantity qty,
+                                         Price old_price, Quantity old_qty) {
+        first_.on_order_modified(id, side, price, qty, old_price, old_qty);
+        second_.on_order_modified(id, side, price, qty, old_price, old_qty);
+    }
+    ALWAYS_INLINE void on_level_update(const L2Delta& delta) {
+        first_.on_level_update(delta);
+        second_.on_level_update(delta);
+    }
+    template <typename Book>
+    ALWAYS_INLINE void on_message_end(const Book& book) {
+        first_.on_message_end(book);
+        second_.on_message_end(book);
+    }
+
+    First& first() noexcept { return first_; }
+    const First& first() const noexcept { return first_; }
+    Second& second() noexcept { return second_; }
+    const Second& second() const noexcept { return second_; }
+};
+
+// True if H keeps NullEventHandler's on_trade, i.e. discards trades; the
+// book then skips per-message work that only feeds trade events (the clock)
+template <typename H>
+inline constexpr bool discards_trades_v = [] {
+    if constexpr (requires { &H::on_trade; }) {
+        return std::is_same_v<decltype(&H::on_trade), decltype(&NullEventHandler::on_trade)>;
+    } else {
+        return false;  // overloaded on_trade
+    }
+}();
+
+template <typename First, typename Second>
+inline constexpr bool discards_trades_v<EventFanout<First, Second>> =
+    discards_trades_v<First> && discards_trades_v<Second>;
@@ -0,0 +1,373 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+#include "BinaryFormat.h"
+#include "LatencyHistogram.h"
+#include "MappedFile.h"
+#include "PriceLevel.h"
+#include "SPSCQueue.h"
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// Write-ahead input journal:
+//   JournalHeader (64 bytes), then frames of JournalFrame (24 bytes)
+//   followed by count BinaryMsgRecords (BinaryFormat.h layout).
+// One frame is one group commit: a single write() and fdatasync() cover
+// every record in it. Frames carry the sequence (input position) of their
+// first record and a checksum, so recovery applies whole frames only and
+// stops at the first torn or corrupt one.
+static_assert(std::endian::native == std::endian::little,
+              "journal format is little-endian");
+
+static constexpr char JOURNAL_MAGIC[8] = {'L', 'O', 'B', 'J', 'R', 'N', 'L', '\0'};
+static constexpr uint32_t JOURNAL_VERSION = 1;
+static constexpr uint32_t JOURNAL_FRAME_MAGIC = 0x4D415246;  // "FRAM"
+
+struct JournalHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t record_size;     // sizeof(BinaryMsgRecord) at write time
+    uint64_t start_sequence;  // sequence of the first record
+    uint64_t reserved[5];
+};
+static_assert(sizeof(JournalHeader) == 64, "header layout is part of the format");
+
+struct JournalFrame {
+    uint32_t magic;           // JOURNAL_FRAME_MAGIC
+    uint32_t count;           // records in this frame
+    uint64_t first_sequence;  // frames are contiguous: previous first + count
+    uint64_t checksum;        // journal_checksum() of the records
+};
+static_assert(sizeof(JournalFrame) == 24, "frame layout is part of the format");
+
+inline uint64_t journal_checksum(const BinaryMsgRecord* records, size_t count) noexcept {
+    const char* p = reinterpret_cast<const char*>(records);
+    size_t words = count * sizeof(BinaryMsgRecord) / sizeof(uint64_t);
+    uint64_t h = 0x9E3779B97F4A7C15ULL ^ count;
+    for (size_t i = 0; i < words; ++i) {
+        uint64_t w;
+        std::memcpy(&w, p + i * sizeof(uint64_t), sizeof(w));
+        h = (h ^ w) * 0xFF51AFD7ED558CCDULL;
+        h ^= h >> 32;
+    }
+    return h;
+}
+
+struct JournalOptions {
+    size_t ring_size = 64 * 1024;    // records buffered between engine and writer
+    uint64_t group_commit_us = 100;  // a batch waits at most this long for more records (0: commit what is there)
+    size_t max_batch = 4096;         // records per frame
+    bool sync = true;                // fdatasync every frame (false: page cache only)
+};
+
+// Appends messages from the engine thread; a dedicated writer thread drains
+// them over an SPSC ring into group-commit frames. append() never touches
+// the file (it blocks only when the ring is full); a record is durable once
+// durable_sequence() has passed it, so anything observable outside the
+// process (acks, trade reports) should be released through wait_durable().
+//
+//   Journal journal(path, book.get_total_messages());
+//   journal.append(msg);  book.process_message(msg);
+//   ...
+//   journal.close();      // commits the rest and joins the writer
+class Journal {
+private:
+    SPSCQueue<BinaryMsgRecord> ring_;
+    JournalOptions options_;
+    int fd_ = -1;
+    uint64_t next_sequence_;          // engine side
+    uint64_t append_stalls_ = 0;
+    std::atomic<uint64_t> durable_;   // every sequence below this is committed
+    std::atomic<bool> failed_{false};
+    std::string error_;               // set before failed_ / open failure
+    std::thread writer_;
+    bool open_ = false;
+    bool closed_ = false;
+
+    // Writer side (read by the engine only after close())
+    uint64_t next_frame_sequence_;
+    uint64_t frames_ = 0;
+    uint64_t records_ = 0;
+    LatencyHistogram sync_ns_;
+
+    static uint64_t now_ns() noexcept {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    bool write_all(const char* data, size_t size) noexcept {
+        while (size > 0) {
+#ifdef _WIN32
+            int n = ::_write(fd_, data, static_cast<unsigned>(size));
+#else
+            ssize_t n = ::write(fd_, data, size);
+            if (n < 0 && errno == EINTR) continue;
+#endif
+            if (n <= 0) return false;
+            data += n;
+            size -= static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+    bool sync_file() noexcept {
+#ifdef _WIN32
+        return ::_commit(fd_) == 0;
+#elif defined(__APPLE__)
+        return ::fsync(fd_) == 0;
+#else
+        return ::fdatasync(fd_) == 0;
+#endif
+    }
+
+    void fail(const char* what) {
+        error_ = std::string(what) + ": " + std::strerror(errno);
+        failed_.store(true, std::memory_order_release);
+    }
+
+    // One group commit: frame + records in one write, then one sync
+    void commit(std::vector<char>& buf, size_t count) {
+        uint64_t first = next_frame_sequence_;
+        next_frame_sequence_ += count;
+        auto* records = reinterpret_cast<const BinaryMsgRecord*>(buf.data() + sizeof(JournalFrame));
+        JournalFrame frame{JOURNAL_FRAME_MAGIC, static_cast<uint32_t>(count), first,
+                           journal_checksum(records, count)};
+        std::memcpy(buf.data(), &frame, sizeof(frame));
+
+        if (!failed_.load(std::memory_order_relaxed)) {
+            if (!write_all(buf.data(), sizeof(JournalFrame) + count * sizeof(BinaryMsgRecord))) {
+                fail("journal write");
+            } else if (options_.sync) {
+                uint64_t t0 = now_ns();
+                if (!sync_file()) fail("journal sync");
+                sync_ns_.record(now_ns() - t0);
+            }
+        }
+        frames_++;
+        records_ += count;
+        if (!failed_.load(std::memory_order_relaxed)) {
+            durable_.store(first + count, std::memory_order_release);
+        }
+    }
+
+    void run() {
+        std::vector<char> buf(sizeof(JournalFrame) + options_.max_batch * sizeof(BinaryMsgRecord));
+        auto* batch = reinterpret_cast<BinaryMsgRecord*>(buf.data() + sizeof(JournalFrame));
+        const uint64_t interval_ns = options_.group_commit_us * 1000;
+        uint64_t idle = 0;
+
+        for (bool closed = false; !closed;) {
+            // Gather until the batch is full, its window has passed, or the
+            // engine closed the ring; records keep arriving during the sync
+            // of the previous frame, so busy periods commit large batches
+            size_t n = 0;
+            uint64_t deadline = 0;
+            while (n < options_.max_batch) {
+                const BinaryMsgRecord* recs;
+                size_t k = ring_.peek(recs, options_.max_batch - n);
+                if (k > 0) {
+                    if (n == 0) deadline = now_ns() + interval_ns;
+                    std::memcpy(batch + n, recs, k * sizeof(BinaryMsgRecord));
+                    ring_.release(k);
+                    n += k;
+                    idle = 0;
+                    continue;
+                }
+                if (ring_.drained()) {
+                    closed = true;
+                    break;
+                }
+                if (n > 0 && now_ns() >= deadline) break;
+                if (++idle < 1024) {
+                    spsc_backoff(idle);
+                } else {
+                    std::this_thread::sleep_for(std::chrono::microseconds(20));
+                }
+            }
+            if (n > 0) commit(buf, n);
+        }
+    }
+
+public:
+    // Creates (truncates) path; the first appended message gets sequence
+    // start_sequence (the book's get_total_messages() when journaling starts)
+    explicit Journal(const std::string& path, uint64_t start_sequence = 0, JournalOptions options = {})
+        : ring_(options.ring_size), options_(options), next_sequence_(start_sequence),
+          durable_(start_sequence), next_frame_sequence_(start_sequence) {
+        if (options_.max_batch == 0) options_.max_batch = 1;
+#ifdef _WIN32
+        fd_ = ::_open(path.c_str(), _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, 0644);
+#else
+        fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+#endif
+        if (fd_ < 0) {
+            error_ = "could not open " + path + ": " + std::strerror(errno);
+            return;
+        }
+        JournalHeader header{};
+        std::memcpy(header.magic, JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC));
+        header.version = JOURNAL_VERSION;
+        header.record_size = sizeof(BinaryMsgRecord);
+        header.start_sequence = start_sequence;
+        if (!write_all(reinterpret_cast<const char*>(&header), sizeof(header)) || !sync_file()) {
+            error_ = "could not write journal header to " + path + ": " + std::strerror(errno);
+            return;
+        }
+        open_ = true;
+        writer_ = std::thread([this] { run(); });
+    }
+
+    ~Journal() { close(); }
+
+    Journal(const Journal&) = delete;
+    Journal& operator=(const Journal&) = delete;
+
+    // False if the file could not be created (append() must not be used)
+    bool is_open() const noexcept { return open_; }
+    bool failed() const noexcept { return failed_.load(std::memory_order_acquire); }
+    // Why the file could not be opened, or the first write/sync failure
+    // (check failed() first while the writer runs)
+    const std::string& error() const noexcept { return error_; }
+
+    // Engine thread: queue msg, return its sequence
+    ALWAYS_INLINE uint64_t append(const Msg& msg) noexcept {
+        BinaryMsgRecord* slot;
+        while (UNLIKELY(ring_.claim(slot, 1) == 0)) {
+            spsc_backoff(++append_stalls_);
+        }
+        *slot = to_binary_record(msg);
+        ring_.publish(1);
+        return next_sequence_++;
+    }
+
+    // Sequence the next append() gets
+    uint64_t next_sequence() const noexcept { return next_sequence_; }
+    // Every record with a sequence below this has been committed
+    uint64_t durable_sequence() const noexcept { return durable_.load(std::memory_order_acquire); }
+
+    // Wait until the record with this sequence is committed; false if the
+    // writer failed (the record may not be on disk)
+    bool wait_durable(uint64_t sequence) const noexcept {
+        uint64_t spins = 0;
+        while (durable_sequence() <= sequence && !failed()) {
+            spsc_backoff(++spins);
+        }
+        return !failed();
+    }
+
+    // Commit everything appended, stop the writer and close the file;
+    // false if any write or sync failed
+    bool close() {
+        if (closed_) return !failed();
+        closed_ = true;
+        if (writer_.joinable()) {
+            ring_.close();
+            writer_.join();
+        }
+        if (fd_ >= 0) {
+#ifdef _WIN32
+            ::_close(fd_);
+#else
+            ::close(fd_);
+#endif
+        }
+        return !failed();
+    }
+
+    // Counters (writer side valid after close())
+    uint64_t append_stalls() const noexcept { return append_stalls_; }
+    uint64_t frames() const noexcept { return frames_; }
+    uint64_t records() const noexcept { return records_; }
+    const LatencyHistogram& sync_latency_ns() const noexcept { return sync_ns_; }
+};
+
+struct JournalRecovery {
+    bool ok = false;
+    std::string error;
+    uint64_t frames = 0;       // complete, valid frames read
+    uint64_t applied = 0;      // records fed to the book
+    uint64_t skipped = 0;      // records already covered by the book (snapshot)
+    bool torn_tail = false;    // bytes after the last valid frame were ignored
+};
+
+// Replays a journal into book, resuming at book.get_total_messages() (0
+// for a fresh book, the snapshot sequence after load_snapshot()). Frames
+// are applied whole, in order, up to the first incomplete or corrupt one
+// (checksum mismatch or a record is_valid_record() rejects), which is where
+// a crash cut the journal; records the book already includes are skipped.
+template <typename Book>
+JournalRecovery recover_journal(const std::string& path, Book& book) {
+    JournalRecovery result;
+    MappedFile file(path);
+    if (!file.is_open()) {
+        result.error = "could not open " + path;
+        return result;
+    }
+    if (file.size() < sizeof(JournalHeader)) {
+        result.error = "file too small for header";
+        return result;
+    }
+    const auto* header = reinterpret_cast<const JournalHeader*>(file.data());
+    if (std::memcmp(header->magic, JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC)) != 0) {
+        result.error = "bad magic (not a journal)";
+        return result;
+    }
+    if (header->version != JOURNAL_VERSION || header->record_size != sizeof(BinaryMsgRecord)) {
+        result.error = "unsupported version " + std::to_string(header->version);
+        return result;
+    }
+    uint64_t position = book.get_total_messages();
+    if (header->start_sequence > position) {
+        result.error = "journal starts at message " + std::to_string(header->start_sequence) +
+                       " but the book is at " + std::to_string(position);
+        return result;
+    }
+
+    size_t offset = sizeof(JournalHeader);
+    uint64_t sequence = header->start_sequence;
+    Msg msg{};
+    while (offset + sizeof(JournalFrame) <= file.size()) {
+        JournalFrame frame;
+        std::memcpy(&frame, file.data() + offset, sizeof(frame));
+        size_t bytes = sizeof(JournalFrame) + size_t(frame.count) * sizeof(BinaryMsgRecord);
+        if (frame.magic != JOURNAL_FRAME_MAGIC || frame.first_sequence != sequence ||
+            bytes > file.size() - offset) {
+            break;
+        }
+        const auto* records = reinterpret_cast<const BinaryMsgRecord*>(file.data() + offset + sizeof(JournalFrame));
+        if (journal_checksum(records, frame.count) != frame.checksum ||
+            !std::all_of(records, records + frame.count, is_valid_record)) {
+            break;
+        }
+
+        for (uint32_t i = 0; i < frame.count; ++i, ++sequence) {
+            if (sequence < position) {
+                result.skipped++;
+                continue;
+            }
+            to_msg(records[i], msg);
+            book.process_message(msg);
+            result.applied++;
+        }
+        result.frames++;
+        offset += bytes;
+    }
+    result.torn_tail = offset < file.size();
+    result.ok = true;
+    return result;
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include "PriceLevel.h"
+
+// Fixed-memory log-linear latency histogram (HDR-style).
+//
+// Values below 2 * SUB_BUCKETS get one bucket each; above that every power
+// of two is split into SUB_BUCKETS linear steps, so a recorded value is known
+// to within 1 / SUB_BUCKETS (~3%) of itself at any magnitude. Recording is an
+// index computation and an increment: every message can be recorded, no
+// sampling, no sort at the end. Units are the caller's (e.g. TSC ticks).
+class LatencyHistogram {
+public:
+    static constexpr unsigned SUB_BUCKET_BITS = 5;
+    static constexpr unsigned MAX_VALUE_BITS = 40;   // larger values clamp to the top bucket
+    static constexpr size_t SUB_BUCKETS = size_t(1) << SUB_BUCKET_BITS;
+    static constexpr size_t BUCKETS = (MAX_VALUE_BITS - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+    static constexpr uint64_t MAX_VALUE = (uint64_t(1) << MAX_VALUE_BITS) - 1;
+
+    static constexpr size_t bucket_index(uint64_t value) noexcept {
+        value = std::min(value, MAX_VALUE);
+        if (value < 2 * SUB_BUCKETS) return static_cast<size_t>(value);
+        unsigned shift = static_cast<unsigned>(std::bit_width(value)) - 1 - SUB_BUCKET_BITS;
+        return (shift + 1) * SUB_BUCKETS + static_cast<size_t>(value >> shift) - SUB_BUCKETS;
+    }
+
+    // Largest value that lands in bucket idx
+    static constexpr uint64_t bucket_upper(size_t idx) noexcept {
+        if (idx < 2 * SUB_BUCKETS) return idx;
+        unsigned shift = static_cast<unsigned>(idx / SUB_BUCKETS) - 1;
+        uint64_t sub = idx % SUB_BUCKETS + SUB_BUCKETS;
+        return ((sub + 1) << shift) - 1;
+    }
+
+    ALWAYS_INLINE void record(uint64_t value) noexcept {
+        counts_[bucket_index(value)]++;
+        count_++;
+        sum_ += value;
+        min_ = std::min(min_, value);
+        max_ = std::max(max_, value);
+    }
+
+    void merge(const LatencyHistogram& other) noexcept {
+        for (size_t i = 0; i < BUCKETS; ++i) counts_[i] += other.counts_[i];
+        count_ += other.count_;
+        sum_ += other.sum_;
+        min_ = std::min(min_, other.min_);
+        max_ = std::max(max_, other.max_);
+    }
+
+    void reset() noexcept { *this = LatencyHistogram(); }
+
+    uint64_t count() const noexcept { return count_; }
+    uint64_t min() const noexcept { return count_ ? min_ : 0; }
+    uint64_t max() const noexcept { return max_; }
+    double mean() const noexcept { return count_ ? static_cast<double>(sum_) / count_ : 0.0; }
+
+    // Smallest bucket bound covering p percent of the values (never above
+    // max()); 0 when empty
+    uint64_t percentile(double p) const noexcept {
+        if (count_ == 0) return 0;
+        uint64_t rank = static_cast<uint64_t>(p / 100.0 * static_cast<double>(count_) + 0.5);
+        rank = std::clamp<uint64_t>(rank, 1, count_);
+        uint64_t seen = 0;
+        for (size_t i = 0; i < BUCKETS; ++i) {
+            seen += counts_[i];
+            if (seen >= rank) return std::min(bucket_upper(i), max_);
+        }
+        return max_;
+    }
+
+private:
+    std::array<uint64_t, BUCKETS> counts_{};
+    uint64_t count_ = 0;
+    uint64_t sum_ = 0;
+    uint64_t min_ = UINT64_MAX;
+    uint64_t max_ = 0;
+};
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <vector>
+#include "PriceLevel.h"
+
+// Level churn counters kept by every book side
+struct LevelStats {
+    uint64_t created = 0;      // levels opened (absent -> resting orders)
+    uint64_t destroyed = 0;    // levels emptied and taken off the side
+    uint64_t cache_hits = 0;   // opens served from the near-touch level cache
+    size_t cached = 0;         // emptied levels held in that cache now
+
+    LevelStats& operator+=(const LevelStats& other) noexcept {
+        created += other.created;
+        destroyed += other.destroyed;
+        cache_hits += other.cache_hits;
+        cached += other.cached;
+        return *this;
+    }
+};
+
+// Arena for the tree nodes that hold PriceLevels (one block per node):
+// fixed-size chunks that never move and a LIFO free list threaded through
+// released blocks, like OrderPool. The block size is taken from the first
+// allocation, since only the tree knows its node type.
+class NodeArena {
+public:
+    static constexpr size_t DEFAULT_CHUNK_NODES = 1024;
+
+private:
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+    struct ChunkDeleter {
+        void operator()(std::byte* p) const noexcept {
+            ::operator delete[](p, std::align_val_t{alignof(std::max_align_t)});
+        }
+    };
+
+    std::vector<std::unique_ptr<std::byte[], ChunkDeleter>> chunks_;
+    FreeBlock* free_head_ = nullptr;
+    std::byte* bump_ = nullptr;
+    std::byte* bump_end_ = nullptr;
+    size_t block_size_ = 0;
+    size_t chunk_nodes_;
+
+    void add_chunk() {
+        auto* raw = static_cast<std::byte*>(
+            ::operator new[](chunk_nodes_ * block_size_, std::align_val_t{alignof(std::max_align_t)}));
+        chunks_.emplace_back(raw);
+        bump_ = raw;
+        bump_end_ = raw + chunk_nodes_ * block_size_;
+    }
+
+public:
+    explicit NodeArena(size_t chunk_nodes = DEFAULT_CHUNK_NODES)
+        : chunk_nodes_(chunk_nodes ? chunk_nodes : DEFAULT_CHUNK_NODES) {}
+
+    NodeArena(const NodeArena&) = delete;
+    NodeArena& operator=(const NodeArena&) = delete;
+
+    // Whether blocks of this arena can hold an object of the given shape
+    bool fits(size_t size, size_t align) noexcept {
+        if (block_size_ == 0) {
+            block_size_ = (size + alignof(std::max_align_t) - 1) / alignof(std::max_align_t) *
+                          alignof(std::max_align_t);
+        }
+        return size <= block_size_ && align <= alignof(std::max_align_t);
+    }
+
+    ALWAYS_INLINE void* allocate() {
+        if (LIKELY(free_head_ != nullptr)) {
+            void* block = free_head_;
+            free_head_ = free_head_->next;
+            return block;
+        }
+        if (UNLIKELY(bump_ == bump_end_)) {
+            add_chunk();
+        }
+        void* block = bump_;
+        bump_ += block_size_;
+        return block;
+    }
+
+    ALWAYS_INLINE void release(void* block) noexcept {
+        auto* freed = static_cast<FreeBlock*>(block);
+        freed->next = free_head_;
+        free_head_ = freed;
+    }
+
+    size_t chunks() const noexcept { return chunks_.size(); }
+};
+
+// std::allocator replacement drawing single objects (tree nodes) from a
+// NodeArena; anything the arena cannot hold goes to operator new
+template <typename T>
+class ArenaAllocator {
+private:
+    template <typename U>
+    friend class ArenaAllocator;
+
+    NodeArena* arena_;
+
+public:
+    using value_type = T;
+
+    explicit ArenaAllocator(NodeArena* arena) noexcept : arena_(arena) {}
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) noexcept : arena_(other.arena_) {}
+
+    T* allocate(size_t n) {
+        if (LIKELY(n == 1 && arena_->fits(sizeof(T), alignof(T)))) {
+            return static_cast<T*>(arena_->allocate());
+        }
+        return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t{alignof(T)}));
+    }
+
+    void deallocate(T* p, size_t n) noexcept {
+        if (LIKELY(n == 1 && arena_->fits(sizeof(T), alignof(T)))) {
+            arena_->release(p);
+        } else {
+            ::operator delete(p, std::align_val_t{alignof(T)});
+        }
+    }
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U>& other) const noexcept { return arena_ == other.arena_; }
+};
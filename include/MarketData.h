@@ -0,0 +1,96 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include "PriceLevel.h"
+
+// L2 (price-level) market data: incremental deltas and top-N depth
+
+enum class L2Action : uint8_t {
+    Add,     // level appeared
+    Modify,  // quantity or order count changed
+    Delete   // level emptied
+};
+
+// State of one level after a change: qty and orders are the new totals
+struct L2Delta {
+    Side     side;
+    L2Action action;
+    uint32_t orders;
+    Price    price;
+    Quantity qty;
+};
+
+// Caller-owned structure-of-arrays output for one side of a depth snapshot;
+// each array holds at least as many entries as levels requested
+struct DepthBuffers {
+    Price*    prices;
+    Quantity* qtys;
+    uint32_t* order_counts;
+};
+
+struct DepthLevels {
+    size_t bids;   // levels written per side (best first)
+    size_t asks;
+};
+
+// Fixed-size top-N depth, trivially copyable so it can be published and
+// read with a single memcpy
+template <size_t N>
+struct DepthSide {
+    Price    prices[N];
+    Quantity qtys[N];
+    uint32_t order_counts[N];
+    uint32_t levels;
+
+    DepthBuffers buffers() noexcept { return {prices, qtys, order_counts}; }
+};
+
+template <size_t N>
+struct DepthSnapshot {
+    uint64_t sequence;   // book message count when taken
+    DepthSide<N> bids;
+    DepthSide<N> asks;
+};
+
+// Single-writer / many-reader publication of a DepthSnapshot (seqlock).
+// The writer never waits for readers; a reader copies the snapshot and
+// retries if a publish overlapped the copy.
+template <size_t N>
+class SeqlockDepth {
+private:
+    static_assert(std::is_trivially_copyable_v<DepthSnapshot<N>>);
+
+    alignas(64) std::atomic<uint64_t> seq_{0};   // odd while a write is in progress
+    alignas(64) DepthSnapshot<N> data_{};
+
+public:
+    // Writer (matching thread) only
+    void publish(const DepthSnapshot<N>& snapshot) noexcept {
+        uint64_t seq = seq_.load(std::memory_order_relaxed);
+        seq_.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        std::memcpy(&data_, &snapshot, sizeof(data_));
+        seq_.store(seq + 2, std::memory_order_release);
+    }
+
+    // One attempt; false if a publish overlapped the copy
+    bool try_read(DepthSnapshot<N>& out) const noexcept {
+        uint64_t before = seq_.load(std::memory_order_acquire);
+        if (before & 1) return false;
+        std::memcpy(&out, &data_, sizeof(out));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return seq_.load(std::memory_order_relaxed) == before;
+    }
+
+    void read(DepthSnapshot<N>& out) const noexcept {
+        while (!try_read(out)) {
+        }
+    }
+
+    // Number of completed publishes
+    uint64_t version() const noexcept { return seq_.load(std::memory_order_acquire) / 2; }
+};
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "Message.h"
+#include "OrderBook.h"
+#include "SPSCQueue.h"
+
+// Build of the engine's per-symbol books. A shard may own thousands of
+// them, most resting few orders, so nothing is sized up front: levels live
+// in a std::map whose nodes come from an arena grown on demand (a dense
+// ladder narrower than a symbol's live price range re-centers on every
+// touch change, and one wide enough costs 128 KB per side per symbol), and
+// the hash id index starts at 256 slots (each symbol sees a sparse slice
+// of the feed's ids). Books discard events (NullEventHandler): trades are
+// counted, not stored. A worker's books share one OrderPool (its region is
+// the worker's, not each symbol's), so a book is about 14 KB resident with
+// a couple of resting orders and no mappings of its own.
+struct ShardBookPolicy : DefaultBookPolicy {
+    template <Side S>
+    using book_side = MapBookSide<S>;
+    using order_index = SizedFlatOrderIndex<256>;
+    using order_pool = SharedOrderPool;
+};
+
+using ShardBook = BasicOrderBook<NullEventHandler, ShardBookPolicy>;
+extern template class BasicOrderBook<NullEventHandler, ShardBookPolicy>;
+
+struct WorkerStats {
+    uint64_t messages;      // messages applied by this worker
+    uint64_t books;         // symbols owned by this worker
+    uint64_t idle_spins;    // worker found its queue empty
+    uint64_t submit_stalls; // dispatcher found this worker's queue full
+    PoolStats orders;       // the OrderPool its books share (after stop())
+};
+
+// Multi-symbol front-end: one ShardBook per symbol, books sharded across
+// worker threads by symbol % workers. Each worker owns its books outright
+// (no locks); a single dispatcher thread routes messages to workers over
+// per-worker SPSC queues, so every symbol sees its messages in submit order.
+// Nothing is held back between submit calls: a message is visible to its
+// worker by the time submit returns.
+//
+//   MatchingEngine engine(4);
+//   for (const Msg& m : feed) engine.submit(m);   // dispatcher thread only
+//   engine.submit(feed.data(), feed.size());      // or in runs (fewer publishes)
+//   engine.stop();                                // drain and join
+//   engine.for_each_book([](uint32_t symbol, const ShardBook& book) { ... });
+//
+// Books are only safe to inspect after stop().
+class MatchingEngine {
+public:
+    static constexpr size_t DEFAULT_QUEUE_CAPACITY = 64 * 1024;
+    static constexpr size_t SUBMIT_BATCH = 256;          // ring slots claimed / applied at a time
+    // Dense symbol ids. Address space goes by workers (one ORDER_REGION_BYTES
+    // pool each, holding up to OrderPool::MAX_ORDERS live orders across its
+    // symbols), so the bound here is book memory: about 0.9 GB if every id
+    // gets a book. Worker counts are capped at MAX_SYMBOLS, as a worker
+    // beyond that would own no symbols.
+    static constexpr uint32_t MAX_SYMBOLS = 64 * 1024;
+
+    explicit MatchingEngine(size_t workers,
+                            size_t queue_capacity = DEFAULT_QUEUE_CAPACITY,
+                            bool pin_threads = true);
+    ~MatchingEngine();
+
+    MatchingEngine(const MatchingEngine&) = delete;
+    MatchingEngine& operator=(const MatchingEngine&) = delete;
+
+    // Route one message to its symbol's worker and publish it (one release
+    // store; ring slots are still claimed SUBMIT_BATCH at a time). Returns
+    // false (and drops the message) if the symbol id is out of range or the
+    // engine is stopped.
+    HOT bool submit(const Msg& msg);
+
+    // Route a run of messages: each worker's share is published whenever its
+    // claimed slots fill, and the remainder before returning. Returns the
+    // number accepted.
+    HOT size_t submit(const Msg* msgs, size_t count);
+
+    // Close the queues, let the workers drain them and join (idempotent)
+    void stop();
+
+    // Messages applied by all workers so far (safe while running)
+    uint64_t processed() const noexcept;
+
+    size_t worker_count() const noexcept { return workers_.size(); }
+    size_t symbol_count() const noexcept;
+    uint64_t rejected() const noexcept { return rejected_; }
+    WorkerStats worker_stats(size_t worker) const noexcept;
+
+    // Book for a symbol, or nullptr if it never received a message
+    const ShardBook* book(uint32_t symbol) const noexcept;
+
+    // f(symbol, book) in ascending symbol order
+    template <typename F>
+    void for_each_book(F&& f) const {
+        for (uint32_t symbol = 0; symbol < symbol_limit_; ++symbol) {
+            if (const ShardBook* b = book(symbol)) f(symbol, *b);
+        }
+    }
+
+private:
+    struct Worker {
+        SPSCQueue<Msg> queue;
+        OrderPool orders;                               // shared by books (outlives them)
+        std::vector<std::unique_ptr<ShardBook>> books;  // by symbol / workers
+        std::thread thread;
+        std::atomic<uint64_t> messages{0};
+        uint64_t idle_spins = 0;
+
+        // Dispatcher side: the claimed span of free queue slots (staged_room
+        // of them), the first staged_count filled and not yet published (own
+        // cache line, away from the worker's counters)
+        alignas(64) Msg* staged = nullptr;
+        size_t staged_count = 0;
+        size_t staged_room = 0;
+        uint64_t submit_stalls = 0;
+
+        explicit Worker(size_t capacity) : queue(capacity) {}
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    uint32_t symbol_limit_;     // one past the highest symbol submitted
+    uint64_t rejected_;
+    bool running_;
+
+    void run_worker(size_t index, int cpu);
+    HOT Worker* stage(const Msg& msg);
+    void publish_staged(Worker& worker);
+    void flush();
+};
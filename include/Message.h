@@ -1,25 +1,48 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
-#include <chrono>
 
-enum class MsgType {
+enum class MsgType : uint8_t {
     NewLimit,
     NewMarket,
-    Cancel
+    Cancel,
+    Modify,        // amend price/qty; a same-price reduction keeps priority
+    CancelReplace  // replace price/qty; always re-queued at the back
 };
+static constexpr size_t MSG_TYPES = static_cast<size_t>(MsgType::CancelReplace) + 1;
 
-enum class Side {
+// Messages addressed to a resting order by id
+constexpr bool targets_resting_order(MsgType type) noexcept {
+    return type == MsgType::Cancel || type == MsgType::Modify || type == MsgType::CancelReplace;
+}
+
+enum class Side : uint8_t {
     Buy,
     Sell
 };
 
+constexpr Side opposite(Side side) noexcept {
+    return side == Side::Buy ? Side::Sell : Side::Buy;
+}
+
+// Time in force of a NewLimit (other message types ignore it; a market order
+// never rests anyway)
+enum class TimeInForce : uint8_t {
+    GTC,       // rest any residual (default)
+    IOC,       // trade what crosses now, drop the residual
+    FOK,       // trade the whole qty now or nothing (book left untouched)
+    PostOnly   // rest only: rejected if it would cross on arrival
+};
+
 struct Msg {
     MsgType type;
-    Side    side;     // ignored for Cancel
-    uint64_t id;      // unique order id
-    int64_t price;    // ticks (ignored for NewMarket/Cancel)
-    int64_t qty;      // lots (0 for Cancel)
-    std::chrono::steady_clock::time_point ts;
+    Side    side;     // ignored for Cancel/Modify/CancelReplace (the order's side)
+    TimeInForce tif;  // NewLimit only (GTC in a value-initialized Msg)
+    uint32_t symbol;  // instrument id (dense, 0 for single-symbol feeds)
+    uint64_t id;      // unique order id (the resting order's for Cancel/Modify/CancelReplace)
+    int64_t price;    // ticks (ignored for NewMarket/Cancel; new price for Modify/CancelReplace)
+    int64_t qty;      // lots (0 for Cancel; new open qty for Modify/CancelReplace, <= 0 cancels)
+    uint64_t ts_ns;   // exchange timestamp from the input (ns)
 };
 
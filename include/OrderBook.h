@@ -1,177 +1,187 @@
 #pragma once
 
-#include <map>
+#include <span>
+#include <string>
+#include <type_traits>
+#include <utility>
 #include <vector>
-#include <unordered_map>
 #include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
 #include "Message.h"
 #include "Trade.h"
+#include "PriceLevel.h"
+#include "PriceLadder.h"
+#include "OrderPool.h"
+#include "OrderIndex.h"
+#include "EventHandlers.h"
+#include "Clock.h"
+#include "Snapshot.h"
 
-// Compiler hints for maximum optimization
-#ifdef __GNUC__
-#define LIKELY(x)   __builtin_expect(!!(x), 1)
-#define UNLIKELY(x) __builtin_expect(!!(x), 0)
-#define HOT         __attribute__((hot))
-#define ALWAYS_INLINE __attribute__((always_inline)) inline
-#define PREFETCH(addr) __builtin_prefetch(addr, 0, 3)
-#else
-#define LIKELY(x)   (x)
-#define UNLIKELY(x) (x)
-#define HOT
-#define ALWAYS_INLINE inline
-#define PREFETCH(addr)
-#endif
-
-// Configuration: Enable/disable trade recording
+// Configuration: OrderBook collects trades (TradeCollector) or discards all
+// events (NullEventHandler); BasicOrderBook<Handler> takes any handler
 static constexpr bool ENABLE_TRADE_RECORDING = true;
 
-using Price = int64_t;
-using OrderId = uint64_t;
-using Quantity = int64_t;
+// Configuration: dense tick ladder (true) or std::map (false) per side
+static constexpr bool ENABLE_PRICE_LADDER = true;
+
+// Configuration: sliding-window id index (dense, monotonic ids) or flat
+// open-addressing hash table (sparse ids)
+static constexpr bool ENABLE_WINDOW_ORDER_INDEX = true;
+
+// Configuration: engine clock stamped on trades (Trade::match_ts); None keeps
+// clock reads off the matching path entirely
+static constexpr ClockSource MATCH_CLOCK = ClockSource::None;
 
-// Compact Order with intrusive list pointers for O(1) cancel
-struct alignas(32) Order {
-    OrderId id;
-    Price price;
-    Quantity qty;
-    Side side;
-    
-    // Intrusive list for O(1) remove
-    Order* next_in_level;
-    Order* prev_in_level;
-    
-    Order() noexcept : next_in_level(nullptr), prev_in_level(nullptr) {}
-    
-    Order(OrderId id, Side side, Price price, Quantity qty) noexcept
-        : id(id), side(side), price(price), qty(qty),
-          next_in_level(nullptr), prev_in_level(nullptr) {}
-    
-    Order(Order&&) noexcept = default;
-    Order& operator=(Order&&) noexcept = default;
-    Order(const Order&) = delete;
-    Order& operator=(const Order&) = delete;
+// Work counters kept by books whose policy sets count_events
+struct BookCounters {
+    uint64_t levels_swept = 0;      // price levels an incoming order traded at
+    uint64_t resting_filled = 0;    // resting orders fully filled
+    uint64_t orders_killed = 0;     // IOC residuals, unfillable FOK, crossing PostOnly
+    uint64_t amends_in_place = 0;   // Modify applied without leaving the queue
 };
 
-// Fast price level using intrusive doubly-linked list
-class PriceLevel {
+// Compile-time build of a book, everything but the handler (which already
+// chooses trade recording and event delivery per instance). The defaults
+// are the Configuration constants above; a deployment derives and
+// overrides members:
+//   struct MapBookPolicy : DefaultBookPolicy {
+//       template <Side S> using book_side = MapBookSide<S>;
+//       using order_index = FlatOrderIndex;
+//   };
+//   BasicOrderBook<NullEventHandler, MapBookPolicy> book;
+struct DefaultBookPolicy {
+    template <Side S>
+    using book_side = std::conditional_t<ENABLE_PRICE_LADDER, PriceLadder<S>, MapBookSide<S>>;
+    using order_index = std::conditional_t<ENABLE_WINDOW_ORDER_INDEX, WindowOrderIndex, FlatOrderIndex>;
+    using order_pool = OrderPool;   // SharedOrderPool: Orders from a pool passed to the constructor
+    static constexpr ClockSource match_clock = MATCH_CLOCK;
+    static constexpr bool count_events = false;   // BookCounters (counters())
+};
+
+// Limit order book, templated on an event-handler policy (EventHandlers.h)
+// that receives trades and order lifecycle events inline, and on a build
+// policy (above). The matcher is written once per side: S is the incoming
+// order's side and the opposite side's levels are levels<opposite(S)>().
+template <typename Handler, typename Policy = DefaultBookPolicy>
+class BasicOrderBook {
 private:
-    Order* head_;
-    Order* tail_;
-    size_t count_;
-    Quantity cached_qty_;  // Cache total quantity (always accurate)
+    template <Side S>
+    using BookSide = typename Policy::template book_side<S>;
+    using OrderIndex = typename Policy::order_index;
+    using OrderStore = typename Policy::order_pool;
     
-public:
-    PriceLevel() noexcept : head_(nullptr), tail_(nullptr), count_(0), cached_qty_(0) {}
+    // Object pool for zero-allocation hot path (slots recycled LIFO)
+    OrderStore order_pool_;
     
-    bool empty() const noexcept { return head_ == nullptr; }
-    size_t size() const noexcept { return count_; }
+    // Price levels per side (Policy::book_side)
+    BookSide<Side::Buy> bids_;
+    BookSide<Side::Sell> asks_;
     
-    Order* get_front() const noexcept { return head_; }
+    // Fast cancel: direct pointer to Order (O(1) cancel, no node allocations)
+    OrderIndex order_pointers_;
     
-    void add_order(Order* order) {
-        order->next_in_level = nullptr;
-        order->prev_in_level = tail_;
-        
-        if (UNLIKELY(head_ == nullptr)) {
-            head_ = tail_ = order;
-        } else {
-            tail_->next_in_level = order;
-            tail_ = order;
-        }
-        
-        count_++;
-        cached_qty_ += order->qty;
-    }
+    Handler handler_;
+    uint64_t total_messages_;
+    uint64_t total_trades_;
+    uint64_t current_event_ts_;   // ts_ns of the message being processed
+    uint64_t current_match_ts_;   // Policy::match_clock reading for that message
+    BookCounters counters_;
     
-    void remove_order(Order* order) {
-        if (UNLIKELY(order == nullptr)) return;
-        
-        cached_qty_ -= order->qty;
-        count_--;
-        
-        if (order->prev_in_level) {
-            order->prev_in_level->next_in_level = order->next_in_level;
-        } else {
-            head_ = order->next_in_level;
-        }
-        
-        if (order->next_in_level) {
-            order->next_in_level->prev_in_level = order->prev_in_level;
-        } else {
-            tail_ = order->prev_in_level;
-        }
-        
-        order->next_in_level = nullptr;
-        order->prev_in_level = nullptr;
+    template <Side S>
+    ALWAYS_INLINE BookSide<S>& levels() noexcept {
+        if constexpr (S == Side::Buy) return bids_; else return asks_;
     }
-    
-    // Update cache when order quantity changes (partial fill)
-    void update_qty(Quantity old_qty, Quantity new_qty) {
-        cached_qty_ += (new_qty - old_qty);
+    template <Side S>
+    ALWAYS_INLINE const BookSide<S>& levels() const noexcept {
+        if constexpr (S == Side::Buy) return bids_; else return asks_;
     }
     
-    void remove_front() {
-        if (LIKELY(head_ != nullptr)) {
-            remove_order(head_);
-        }
+    ALWAYS_INLINE void count(uint64_t BookCounters::* counter) noexcept {
+        if constexpr (Policy::count_events) ++(counters_.*counter);
     }
     
-    Quantity total_qty() const noexcept {
-        return cached_qty_;  // O(1) - always accurate with incremental updates
+    ALWAYS_INLINE Order* allocate_order(OrderId id, Quantity qty) {
+        return order_pool_.allocate(id, qty);
     }
-};
-
-class OrderBook {
-private:
-    // Object pool for zero-allocation hot path
-    static constexpr size_t POOL_SIZE = 2 * 1024 * 1024;
-    std::vector<Order> order_pool_;
-    size_t pool_next_;
-    
-    // Use std::map (fast enough for ~500 price levels)
-    std::map<Price, PriceLevel, std::greater<Price>> bids_;
-    std::map<Price, PriceLevel, std::less<Price>> asks_;
     
-    // Fast cancel: direct pointer to Order (O(1) cancel)
-    std::unordered_map<OrderId, Order*> order_pointers_;
+    ALWAYS_INLINE void release_order(Order* order) noexcept {
+        order_pool_.release(order);
+    }
     
-    std::vector<Trade> trades_;
-    uint64_t total_messages_;
-    uint64_t total_trades_;
-    std::chrono::steady_clock::time_point current_match_ts_;
-    
-    ALWAYS_INLINE Order* allocate_order() {
-        // Object pool: pre-allocated to avoid hot-path allocations
-        if (UNLIKELY(pool_next_ >= order_pool_.size())) {
-            // Grow pool by POOL_SIZE (should rarely happen after warm-up)
-            size_t old_size = order_pool_.size();
-            order_pool_.resize(old_size + POOL_SIZE);
-            // Initialize new Orders (they'll be overwritten but ensures valid state)
-            for (size_t i = old_size; i < order_pool_.size(); ++i) {
-                order_pool_[i] = Order();
-            }
-        }
-        Order* order = &order_pool_[pool_next_++];
-        // Reset intrusive list pointers (in case reused)
-        order->next_in_level = nullptr;
-        order->prev_in_level = nullptr;
-        return order;
+    // L2 delta for a level that just changed (after a fill, rest or cancel,
+    // before an emptied level is erased)
+    ALWAYS_INLINE void publish_level(Side side, Price price, const PriceLevel& level, bool rested = false) {
+        L2Delta delta;
+        delta.side = side;
+        delta.action = level.empty() ? L2Action::Delete
+                     : (rested && level.size() == 1) ? L2Action::Add : L2Action::Modify;
+        delta.orders = static_cast<uint32_t>(level.size());
+        delta.price = price;
+        delta.qty = level.total_qty();
+        handler_.on_level_update(delta);
     }
     
-    ALWAYS_INLINE HOT void match_orders_fast(Order* incoming, Order* resting);
-    ALWAYS_INLINE HOT void match_limit_buy_fast(Order* order);
-    ALWAYS_INLINE HOT void match_limit_sell_fast(Order* order);
-    ALWAYS_INLINE HOT void insert_limit_order_fast(Order* order);
+    // process_batch pipeline stages, each run a fixed distance ahead of the
+    // message being matched (see OrderBookImpl.h)
+    ALWAYS_INLINE void prefetch_index(const Msg& msg) const noexcept;
+    ALWAYS_INLINE const Order* prefetch_order(const Msg& msg) const noexcept;
+    ALWAYS_INLINE void prefetch_level(const Order* order) const noexcept;
+    
+    // An order while it trades on arrival (or on re-entry after a reprice):
+    // what the matcher reads and consumes, kept out of the pool
+    struct Incoming {
+        OrderId id;
+        Price price;
+        Quantity qty;
+    };
+    
+    // Per-side kernels; S is the side of the order being handled
+    template <Side S> ALWAYS_INLINE HOT void match_orders_fast(Incoming& incoming, Order* resting, Price price);
+    template <Side S> ALWAYS_INLINE HOT void add_limit_order(const Msg& msg);
+    template <Side S> ALWAYS_INLINE HOT void add_market_order(const Msg& msg);
+    template <Side S> ALWAYS_INLINE HOT void match_limit_fast(Incoming& order);
+    // Take the whole best opposite level (incoming qty >= its total)
+    template <Side S> ALWAYS_INLINE HOT void retire_level(Incoming& incoming, PriceLevel& level, Price price);
+    template <Side S> ALWAYS_INLINE HOT void insert_limit_order_fast(const Incoming& incoming);
+    // Link a pool Order (already indexed) at the back of its level at price
+    template <Side S> ALWAYS_INLINE void rest_order(Order* order, Price price);
+    // Take a resting order out of its level (it stays indexed and allocated)
+    template <Side S> ALWAYS_INLINE void unlink_order(Order* order);
+    ALWAYS_INLINE void unlink_order(Order* order);
+    template <Side S> ALWAYS_INLINE HOT void amend_order(Order* order, const Msg& msg, bool keep_priority);
+    // Time-in-force checks made before a NewLimit touches the book: would it
+    // trade on arrival (PostOnly), and how much of wanted the other side
+    // holds at or inside price (FOK; the walk stops once wanted is reached)
+    template <Side S> ALWAYS_INLINE bool crosses(Price price) const noexcept;
+    template <Side S> Quantity fillable_qty(Price price, Quantity wanted) const noexcept;
     
 public:
-    OrderBook() : pool_next_(0), total_messages_(0), total_trades_(0) {
-        order_pool_.reserve(POOL_SIZE);
-        order_pool_.resize(POOL_SIZE);
-        trades_.reserve(10 * 1024 * 1024);
-    }
+    using handler_type = Handler;
+    using policy_type = Policy;
+    
+    explicit BasicOrderBook(Handler handler = Handler())
+        requires std::is_default_constructible_v<OrderStore>
+        : handler_(std::move(handler)), total_messages_(0), total_trades_(0) {}
+    
+    // Book drawing its Orders from pool (Policy::order_pool = SharedOrderPool),
+    // which must outlive it
+    explicit BasicOrderBook(OrderPool& pool, Handler handler = Handler())
+        requires std::is_constructible_v<OrderStore, OrderPool&>
+        : order_pool_(pool), handler_(std::move(handler)), total_messages_(0), total_trades_(0) {}
     
     HOT void process_message(const Msg& msg);
     
+    // Same result as process_message over msgs in order, with a software
+    // pipeline that prefetches the id-index slot (2 x lookahead ahead), the
+    // resting Order (lookahead ahead) and its price level (lookahead / 2
+    // ahead) of upcoming messages. lookahead 0 disables prefetching; it is
+    // capped at MAX_LOOKAHEAD.
+    static constexpr size_t DEFAULT_LOOKAHEAD = 8;
+    static constexpr size_t MAX_LOOKAHEAD = 64;
+    HOT void process_batch(std::span<const Msg> msgs, size_t lookahead = DEFAULT_LOOKAHEAD);
+    
     Price best_bid() const noexcept;
     Price best_ask() const noexcept;
     Quantity best_bid_qty() const noexcept;
@@ -179,8 +189,63 @@ public:
     Quantity total_bid_qty() const;
     Quantity total_ask_qty() const;
     
-    std::vector<Trade> get_trades() const { return trades_; }
+    // Top-n levels per side, best first, into caller-owned SoA buffers (no
+    // allocation; walks at most n levels per side)
+    DepthLevels snapshot_depth(size_t n, const DepthBuffers& bids, const DepthBuffers& asks) const noexcept;
+    
+    Handler& handler() noexcept { return handler_; }
+    const Handler& handler() const noexcept { return handler_; }
+    
+    // Trades collected by the handler (empty if it does not collect them)
+    const std::vector<Trade>& get_trades() const noexcept {
+        if constexpr (requires { handler_.trades(); }) {
+            return handler_.trades();
+        } else {
+            static const std::vector<Trade> none;
+            return none;
+        }
+    }
+    void clear_trades() {
+        if constexpr (requires { handler_.clear(); }) handler_.clear();
+    }
+    void reserve_trades(size_t capacity) {
+        if constexpr (requires { handler_.reserve(capacity); }) handler_.reserve(capacity);
+    }
+    
+    // Resting order by id (nullptr if filled, cancelled or unknown)
+    const Order* find_order(OrderId id) const noexcept { return order_pointers_.find(id); }
+    
     uint64_t get_total_messages() const { return total_messages_; }
     uint64_t get_total_trades() const { return total_trades_; }
-    void clear_trades() { trades_.clear(); }
+    
+    // Work counters (all zero unless Policy::count_events)
+    const BookCounters& counters() const noexcept { return counters_; }
+    
+    // Order pool occupancy (live orders, peak, backed capacity); a shared
+    // pool's cover every book drawing from it
+    PoolStats pool_stats() const noexcept { return order_pool_.stats(); }
+    
+    // Price level churn, both sides summed (LevelStats in LevelPool.h)
+    LevelStats level_stats() const noexcept {
+        LevelStats stats = bids_.level_stats();
+        stats += asks_.level_stats();
+        return stats;
+    }
+    
+    // Checkpoint every resting order in price-time order plus the message
+    // and trade counters (format in Snapshot.h). load_snapshot() needs a
+    // fresh book and rebuilds the pool, levels and id index in one pass over
+    // the mapped file, without handler events; replay then resumes at input
+    // index get_total_messages(). Errors go to stderr and return false.
+    bool save_snapshot(const std::string& path) const;
+    bool load_snapshot(const std::string& path);
 };
+
+using OrderBook = BasicOrderBook<
+    std::conditional_t<ENABLE_TRADE_RECORDING, TradeCollector, NullEventHandler>>;
+
+#include "OrderBookImpl.h"
+
+// The stock handlers are compiled once, in OrderBook.cpp
+extern template class BasicOrderBook<TradeCollector>;
+extern template class BasicOrderBook<NullEventHandler>;
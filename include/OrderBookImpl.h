@@ -0,0 +1,533 @@
+#pragma once
+
+// BasicOrderBook<Handler, Policy> member definitions; included by
+// OrderBook.h only (stock handlers are explicitly instantiated in
+// OrderBook.cpp)
+
+// Ultra-fast matching with minimal overhead; an incoming order of side S
+// trades with a resting one at that order's level price
+template <typename Handler, typename Policy>
+template <Side S>
+inline void BasicOrderBook<Handler, Policy>::match_orders_fast(Incoming& incoming, Order* resting, Price price) {
+    // Fast path: calculate match quantity (branchless min)
+    Quantity match_qty = (incoming.qty < resting->qty) ? incoming.qty : resting->qty;
+    
+    // Update quantities first (critical path) - ensures progress
+    incoming.qty -= match_qty;
+    resting->qty -= match_qty;
+    
+    // Trade event (compiles away for NullEventHandler)
+    Trade trade;
+    trade.buy_id = (S == Side::Buy) ? incoming.id : resting->id();
+    trade.sell_id = (S == Side::Buy) ? resting->id() : incoming.id;
+    trade.price = price;
+    trade.qty = match_qty;
+    trade.ts_ns = current_event_ts_;
+    trade.match_ts = current_match_ts_;
+    handler_.on_trade(trade);
+    
+    total_trades_++;
+}
+
+// Match an incoming limit order of side S against the opposite side, best
+// level first, while its price still crosses
+template <typename Handler, typename Policy>
+template <Side S>
+inline void BasicOrderBook<Handler, Policy>::match_limit_fast(Incoming& order) {
+    constexpr Side OTHER = opposite(S);
+    auto& book = levels<OTHER>();
+    
+    while (LIKELY(order.qty > 0 && !book.empty())) {
+        Price best_price = book.best_price();
+        
+        if (UNLIKELY(!SideTraits<S>::crosses(order.price, best_price))) {
+            break;
+        }
+        
+        PriceLevel& level = book.best_level();
+        count(&BookCounters::levels_swept);
+        
+        if (order.qty >= level.total_qty()) {
+            retire_level<S>(order, level, best_price);
+            continue;
+        }
+        
+        // Hot matching loop with prefetch
+        while (LIKELY(order.qty > 0 && !level.empty())) {
+            Order* resting = level.get_front();
+            if (UNLIKELY(resting == nullptr || resting->qty <= 0)) {
+                level.remove_front();
+                continue;
+            }
+            
+            // Prefetch next order
+            if (LIKELY(resting->next_in_level)) {
+                PREFETCH(resting->next());
+            }
+            
+            Quantity resting_qty_before = resting->qty;
+            match_orders_fast<S>(order, resting, best_price);
+            
+            // Update cache for partial/full fill
+            if (resting_qty_before != resting->qty) {
+                level.update_qty(resting_qty_before, resting->qty);
+            }
+            
+            if (UNLIKELY(resting->qty <= 0)) {
+                order_pointers_.erase(resting->id());
+                level.remove_order(resting);
+                release_order(resting);
+                count(&BookCounters::resting_filled);
+            }
+            publish_level(OTHER, best_price, level);
+            
+            // If resting order partially filled, the incoming one is done;
+            // if fully filled, it's removed above, so continue to next order
+        }
+        
+        // Remove empty level
+        if (UNLIKELY(level.empty())) {
+            book.erase(best_price);
+        }
+    }
+}
+
+// Sweep fast path: an incoming order of side S holding at least the best
+// opposite level's total takes all of it. One pass over the queue fills and
+// unindexes each order; the queue then goes back to the pool as one chain,
+// the level publishes a single Delete and leaves the side. The next level
+// is prefetched while this one retires.
+template <typename Handler, typename Policy>
+template <Side S>
+inline void BasicOrderBook<Handler, Policy>::retire_level(Incoming& incoming, PriceLevel& level, Price price) {
+    constexpr Side OTHER = opposite(S);
+    auto& book = levels<OTHER>();
+    book.prefetch_second();
+    
+    size_t filled = level.size();
+    Order* back = level.get_back();
+    Order* front = level.take_all();
+    for (Order* resting = front; resting != nullptr; resting = resting->next()) {
+        if (LIKELY(resting->next_in_level)) {
+            PREFETCH(resting->next());
+        }
+        if (LIKELY(resting->qty > 0)) {
+            match_orders_fast<S>(incoming, resting, price);
+        }
+        order_pointers_.erase(resting->id());
+    }
+    order_pool_.release_chain(front, back, filled);
+    if constexpr (Policy::count_events) counters_.resting_filled += filled;
+    
+    publish_level(OTHER, price, level);
+    book.erase(price);
+}
+
+// NewLimit of side S: time-in-force checks, match, then rest the residual
+template <typename Handler, typename Policy>
+template <Side S>
+inline void BasicOrderBook<Handler, Policy>::add_limit_order(const Msg& msg) {
+    handler_.on_order_accepted(msg.id, S, msg.price, msg.qty);
+    Incoming incoming{msg.id, msg.price, msg.qty};
+    
+    // FOK and PostOnly are decided before any fill, so a rejected order
+    // leaves the book exactly as it was
+    if (UNLIKELY(msg.tif == TimeInForce::PostOnly ? crosses<S>(msg.price)
+                 : msg.tif == TimeInForce::FOK && fillable_qty<S>(msg.price, msg.qty) < msg.qty)) {
+        count(&BookCounters::orders_killed);
+        handler_.on_order_killed(msg.id, S, msg.price, msg.qty);
+        return;
+    }
+    
+    match_limit_fast<S>(incoming);
+    
+    // An IOC residual is dropped here, before the pool or index see it
+    if (LIKELY(incoming.qty > 0)) {
+        if (LIKELY(msg.tif != TimeInForce::IOC)) {
+            insert_limit_order_fast<S>(incoming);
+        } else {
+            count(&BookCounters::orders_killed);
+            handler_.on_order_killed(msg.id, S, msg.price, incoming.qty);
+        }
+    }
+}
+
+// NewMarket of side S: the limit matcher with a limit every opposite price
+// crosses, so it takes the opposite side best level first until filled or
+// the side is empty; the residual is discarded
+template <typename Handler, typename Policy>
+template <Side S>
+inline void BasicOrderBook<Handler, Policy>::add_market_order(const Msg& msg) {
+    handler_.on_order_accepted(msg.id, S, msg.price, msg.qty);
+    Incoming market_order{msg.id, SideTraits<S>::UNBOUNDED, msg.qty};
+    match_limit_fast<S>(market_order);
+}
+
+// Only the residual of a limit order is copied into the pool; orders that
+// fill on arrival never touch it
+template <typename Handler, typename Policy>
+template <Side S>
+inline void BasicOrderBook<Handler, Policy>::insert_limit_order_fast(const Incoming& incoming) {
+    Order* order = allocate_order(incoming.id, incoming.qty);
+    order_pointers_.insert(incoming.id, order);
+    rest_order<S>(order, incoming.price);
+}
+
+template <typename Handler, typename Policy>
+template <Side S>
+inline void BasicOrderBook<Handler, Policy>::rest_order(Order* order, Price price) {
+    PriceLevel& level = levels<S>().get_or_create(price);
+    level.add_order(order);
+    publish_level(S, price, level, true);
+    handler_.on_order_rested(*order);
+}
+
+// Straight through the order's level handle: no price lookup unless the
+// level empties and has to leave the side
+template <typename Handler, typename Policy>
+template <Side S>
+inline void BasicOrderBook<Handler, Policy>::unlink_order(Order* order) {
+    PriceLevel* level = order->level();
+    Price price = level->price();
+    level->remove_order(order);
+    publish_level(S, price, *level);
+    if (UNLIKELY(level->empty())) {
+        levels<S>().erase(price);
+    }
+}
+
+template <typename Handler, typename Policy>
+inline void BasicOrderBook<Handler, Policy>::unlink_order(Order* order) {
+    if (LIKELY(order->side() == Side::Buy)) {
+        unlink_order<Side::Buy>(order);
+    } else {
+        unlink_order<Side::Sell>(order);
+    }
+}
+
+// Modify / CancelReplace of a resting order of side S. A Modify that keeps
+// the price and does not add quantity is applied where the order sits
+// (queue priority kept); anything else leaves the level and re-enters as a
+// limit order at the new price, matching first if it now crosses, in the
+// same pool slot and id-index entry. New qty <= 0 cancels.
+template <typename Handler, typename Policy>
+template <Side S>
+inline void BasicOrderBook<Handler, Policy>::amend_order(Order* order, const Msg& msg, bool keep_priority) {
+    if (UNLIKELY(msg.qty <= 0)) {
+        order_pointers_.erase(msg.id);
+        handler_.on_order_cancelled(*order);
+        unlink_order<S>(order);
+        release_order(order);
+        return;
+    }
+    
+    PriceLevel* level = order->level();
+    Price old_price = level->price();
+    Quantity old_qty = order->qty;
+    
+    if (keep_priority && msg.price == old_price && msg.qty <= old_qty) {
+        if (LIKELY(msg.qty != old_qty)) {
+            level->update_qty(old_qty, msg.qty);
+            order->qty = msg.qty;
+            publish_level(S, old_price, *level);
+        }
+        count(&BookCounters::amends_in_place);
+        handler_.on_order_modified(msg.id, S, msg.price, msg.qty, old_price, old_qty);
+        return;
+    }
+    
+    unlink_order<S>(order);
+    handler_.on_order_modified(msg.id, S, msg.price, msg.qty, old_price, old_qty);
+    
+    // Trades as an incoming order; the pool slot waits to re-rest the residual
+    Incoming reentry{msg.id, msg.price, msg.qty};
+    match_limit_fast<S>(reentry);
+    
+    if (LIKELY(reentry.qty > 0)) {
+        order->qty = reentry.qty;
+        rest_order<S>(order, msg.price);
+    } else {
+        order_pointers_.erase(msg.id);
+        release_order(order);
+    }
+}
+
+template <typename Handler, typename Policy>
+template <Side S>
+inline bool BasicOrderBook<Handler, Policy>::crosses(Price price) const noexcept {
+    const auto& book = levels<opposite(S)>();
+    return !book.empty() && SideTraits<S>::crosses(price, book.best_price());
+}
+
+template <typename Handler, typename Policy>
+template <Side S>
+Quantity BasicOrderBook<Handler, Policy>::fillable_qty(Price price, Quantity wanted) const noexcept {
+    Quantity available = 0;
+    levels<opposite(S)>().for_each_until([&](Price level_price, const PriceLevel& level) {
+        if (!SideTraits<S>::crosses(price, level_price)) return false;
+        available += level.total_qty();
+        return available < wanted;
+    });
+    return available;
+}
+
+template <typename Handler, typename Policy>
+void BasicOrderBook<Handler, Policy>::process_message(const Msg& msg) {
+    // Timestamps once per message (only read by trade events)
+    if constexpr (!discards_trades_v<Handler>) {
+        current_event_ts_ = msg.ts_ns;
+        current_match_ts_ = clock_now<Policy::match_clock>();
+    }
+    total_messages_++;
+    
+    switch (msg.type) {
+        case MsgType::NewLimit:
+            if (LIKELY(msg.side == Side::Buy)) {
+                add_limit_order<Side::Buy>(msg);
+            } else {
+                add_limit_order<Side::Sell>(msg);
+            }
+            break;
+        
+        case MsgType::NewMarket:
+            if (LIKELY(msg.side == Side::Buy)) {
+                add_market_order<Side::Buy>(msg);
+            } else {
+                add_market_order<Side::Sell>(msg);
+            }
+            break;
+        
+        case MsgType::Cancel: {
+            // One probe: lookup and index removal together
+            Order* order = order_pointers_.extract(msg.id);
+            if (LIKELY(order != nullptr)) {
+                handler_.on_order_cancelled(*order);
+                unlink_order(order);
+                release_order(order);
+            }
+            break;
+        }
+        
+        case MsgType::Modify:
+        case MsgType::CancelReplace: {
+            Order* order = order_pointers_.find(msg.id);
+            if (UNLIKELY(order == nullptr)) {
+                break;  // filled, cancelled or unknown
+            }
+            bool keep_priority = msg.type == MsgType::Modify;
+            if (order->side() == Side::Buy) {
+                amend_order<Side::Buy>(order, msg, keep_priority);
+            } else {
+                amend_order<Side::Sell>(order, msg, keep_priority);
+            }
+            break;
+        }
+    }
+    
+    handler_.on_message_end(*this);
+}
+
+// Stage 1: the index slot a cancel or amend will probe
+template <typename Handler, typename Policy>
+inline void BasicOrderBook<Handler, Policy>::prefetch_index(const Msg& msg) const noexcept {
+    if (targets_resting_order(msg.type)) {
+        order_pointers_.prefetch(msg.id);
+    }
+}
+
+// Stage 2: the resting Order a cancel or amend will unlink (its index slot
+// is warm by now), or the level a new limit order would rest on. Returns the
+// Order for stage 3.
+template <typename Handler, typename Policy>
+inline const Order* BasicOrderBook<Handler, Policy>::prefetch_order(const Msg& msg) const noexcept {
+    if (targets_resting_order(msg.type)) {
+        const Order* order = order_pointers_.find(msg.id);
+        if (order) {
+            PREFETCH(order);
+            // Stage 3 reads the level handle from the cold half
+            if constexpr (ENABLE_ORDER_HOT_COLD_SPLIT) PREFETCH(&order->cold());
+        }
+        return order;
+    }
+    if (msg.type == MsgType::NewLimit) {
+        if (msg.side == Side::Buy) {
+            bids_.prefetch(msg.price);
+        } else {
+            asks_.prefetch(msg.price);
+        }
+    }
+    return nullptr;
+}
+
+// Stage 3: the level a cancel or amend will remove from, through the
+// order's level handle. The Order may have been filled and recycled since
+// stage 2 and its handle may be stale; that only wastes a prefetch, since
+// pool slots stay mapped and prefetch never faults.
+template <typename Handler, typename Policy>
+inline void BasicOrderBook<Handler, Policy>::prefetch_level(const Order* order) const noexcept {
+    if (order) {
+        PREFETCH(order->level());
+    }
+}
+
+template <typename Handler, typename Policy>
+void BasicOrderBook<Handler, Policy>::process_batch(std::span<const Msg> msgs, size_t lookahead) {
+    const size_t n = msgs.size();
+    if (lookahead == 0) {
+        for (const Msg& msg : msgs) process_message(msg);
+        return;
+    }
+    
+    // Stage 2 results wait here for stage 3 (ring indexed by message position)
+    constexpr size_t RING = 2 * MAX_LOOKAHEAD;
+    const Order* found[RING];
+    
+    const size_t order_ahead = std::min(lookahead, MAX_LOOKAHEAD);
+    const size_t index_ahead = 2 * order_ahead;
+    const size_t level_ahead = (order_ahead + 1) / 2;
+    
+    // Prime the pipeline so the first messages are covered too
+    for (size_t j = 0; j < std::min(n, index_ahead); ++j) prefetch_index(msgs[j]);
+    for (size_t j = 0; j < std::min(n, order_ahead); ++j) found[j % RING] = prefetch_order(msgs[j]);
+    for (size_t j = 0; j < std::min(n, level_ahead); ++j) prefetch_level(found[j % RING]);
+    
+    for (size_t i = 0; i < n; ++i) {
+        if (i + index_ahead < n) prefetch_index(msgs[i + index_ahead]);
+        if (i + order_ahead < n) found[(i + order_ahead) % RING] = prefetch_order(msgs[i + order_ahead]);
+        if (i + level_ahead < n) prefetch_level(found[(i + level_ahead) % RING]);
+        process_message(msgs[i]);
+    }
+}
+
+template <typename Handler, typename Policy>
+Price BasicOrderBook<Handler, Policy>::best_bid() const noexcept {
+    return bids_.empty() ? 0 : bids_.best_price();
+}
+
+template <typename Handler, typename Policy>
+Price BasicOrderBook<Handler, Policy>::best_ask() const noexcept {
+    return asks_.empty() ? 0 : asks_.best_price();
+}
+
+template <typename Handler, typename Policy>
+Quantity BasicOrderBook<Handler, Policy>::best_bid_qty() const noexcept {
+    return bids_.empty() ? 0 : bids_.best_level().total_qty();
+}
+
+template <typename Handler, typename Policy>
+Quantity BasicOrderBook<Handler, Policy>::best_ask_qty() const noexcept {
+    return asks_.empty() ? 0 : asks_.best_level().total_qty();
+}
+
+template <typename Handler, typename Policy>
+Quantity BasicOrderBook<Handler, Policy>::total_bid_qty() const {
+    Quantity total = 0;
+    bids_.for_each([&](Price, const PriceLevel& level) {
+        total += level.total_qty();
+    });
+    return total;
+}
+
+template <typename Handler, typename Policy>
+Quantity BasicOrderBook<Handler, Policy>::total_ask_qty() const {
+    Quantity total = 0;
+    asks_.for_each([&](Price, const PriceLevel& level) {
+        total += level.total_qty();
+    });
+    return total;
+}
+
+template <typename Handler, typename Policy>
+DepthLevels BasicOrderBook<Handler, Policy>::snapshot_depth(size_t n, const DepthBuffers& bids,
+                                                    const DepthBuffers& asks) const noexcept {
+    auto fill = [n](const auto& side, const DepthBuffers& out) {
+        size_t i = 0;
+        side.for_each_best(n, [&](Price price, const PriceLevel& level) {
+            out.prices[i] = price;
+            out.qtys[i] = level.total_qty();
+            out.order_counts[i] = static_cast<uint32_t>(level.size());
+            i++;
+        });
+        return i;
+    };
+    return {fill(bids_, bids), fill(asks_, asks)};
+}
+
+template <typename Handler, typename Policy>
+bool BasicOrderBook<Handler, Policy>::save_snapshot(const std::string& path) const {
+    std::vector<SnapshotOrder> records;
+    records.reserve(order_pool_.stats().in_use);
+    uint64_t levels = 0;
+    auto append_side = [&](const auto& side) {
+        side.for_each([&](Price price, const PriceLevel& level) {
+            for (const Order* o = level.get_front(); o != nullptr; o = o->next()) {
+                records.push_back(SnapshotOrder{o->id(), price, o->qty});
+            }
+            levels++;
+        });
+    };
+    append_side(bids_);
+    uint64_t bid_orders = records.size();
+    append_side(asks_);
+    
+    SnapshotHeader header{};
+    std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+    header.version = SNAPSHOT_VERSION;
+    header.record_size = sizeof(SnapshotOrder);
+    header.order_count = records.size();
+    header.bid_orders = bid_orders;
+    header.sequence = total_messages_;
+    header.total_trades = total_trades_;
+    header.level_count = levels;
+    
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+        std::cerr << "Error: Could not open file " << path << std::endl;
+        return false;
+    }
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(records.data()),
+              static_cast<std::streamsize>(records.size() * sizeof(SnapshotOrder)));
+    out.close();
+    if (!out) {
+        std::cerr << "Error: failed writing " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+template <typename Handler, typename Policy>
+bool BasicOrderBook<Handler, Policy>::load_snapshot(const std::string& path) {
+    if (total_messages_ != 0 || !order_pointers_.empty()) {
+        std::cerr << "Error: snapshots load into a fresh book only" << std::endl;
+        return false;
+    }
+    SnapshotFile file(path);
+    if (!file.is_valid()) {
+        std::cerr << "Error: " << path << ": " << file.error() << std::endl;
+        return false;
+    }
+    
+    // Records of a level are contiguous and already in time priority, so
+    // each level is looked up once and its orders appended in file order
+    auto restore_side = [&](auto& side, const SnapshotOrder* begin, const SnapshotOrder* end) {
+        PriceLevel* level = nullptr;
+        Price level_price = 0;
+        for (const SnapshotOrder* r = begin; r != end; ++r) {
+            if (level == nullptr || r->price != level_price) {
+                level = &side.get_or_create(r->price);
+                level_price = r->price;
+            }
+            Order* order = allocate_order(r->id, r->qty);
+            level->add_order(order);
+            order_pointers_.insert(r->id, order);
+        }
+    };
+    const SnapshotOrder* split = file.begin() + file.header().bid_orders;
+    restore_side(bids_, file.begin(), split);
+    restore_side(asks_, split, file.end());
+    
+    total_messages_ = file.header().sequence;
+    total_trades_ = file.header().total_trades;
+    return true;
+}
@@ -0,0 +1,209 @@
+#pragma once
+
+#include <bit>
+#include <vector>
+#include "PriceLevel.h"
+
+// Order-id -> Order* index backends. Both share one interface:
+//   find(id)        -> Order* or nullptr
+//   insert(id, o)   insert or overwrite
+//   erase(id)       -> true if the id was present
+//   extract(id)     find + erase in one probe sequence (cancel path)
+//   prefetch(id)    warm the cache line a later lookup will touch
+
+// Flat open-addressing table with linear probing. Deletion shifts the
+// following cluster back instead of leaving tombstones, so probe sequences
+// never degrade under insert/cancel churn. Grows (rehash) at 50% load.
+class FlatOrderIndex {
+private:
+    struct Slot {
+        OrderId id;
+        Order* order;  // nullptr = empty
+    };
+
+    std::vector<Slot> slots_;
+    size_t mask_;
+    size_t size_;
+
+    ALWAYS_INLINE size_t home(OrderId id) const noexcept {
+        // Fibonacci hashing: sequential ids spread across the table
+        return static_cast<size_t>((id * 0x9E3779B97F4A7C15ULL) >> 32) & mask_;
+    }
+
+    void rehash(size_t capacity) {
+        std::vector<Slot> old(capacity, Slot{0, nullptr});
+        old.swap(slots_);
+        mask_ = capacity - 1;
+        size_ = 0;
+        for (const Slot& s : old) {
+            if (s.order != nullptr) {
+                insert(s.id, s.order);
+            }
+        }
+    }
+
+    // Backward-shift deletion starting at an occupied slot
+    void remove_at(size_t i) noexcept {
+        size_t hole = i;
+        size_t j = i;
+        for (;;) {
+            j = (j + 1) & mask_;
+            Slot& s = slots_[j];
+            if (s.order == nullptr) break;
+            // Move s into the hole unless its home lies cyclically in (hole, j]
+            size_t h = home(s.id);
+            if (((j - h) & mask_) >= ((j - hole) & mask_)) {
+                slots_[hole] = s;
+                hole = j;
+            }
+        }
+        slots_[hole].order = nullptr;
+        size_--;
+    }
+
+public:
+    static constexpr size_t DEFAULT_CAPACITY = 64 * 1024;
+
+    explicit FlatOrderIndex(size_t capacity = DEFAULT_CAPACITY)
+        : slots_(std::bit_ceil(capacity < 16 ? size_t(16) : capacity), Slot{0, nullptr}),
+          mask_(slots_.size() - 1), size_(0) {}
+
+    size_t size() const noexcept { return size_; }
+    bool empty() const noexcept { return size_ == 0; }
+    size_t capacity() const noexcept { return slots_.size(); }
+
+    ALWAYS_INLINE Order* find(OrderId id) const noexcept {
+        for (size_t i = home(id);; i = (i + 1) & mask_) {
+            const Slot& s = slots_[i];
+            if (s.order == nullptr) return nullptr;
+            if (s.id == id) return s.order;
+        }
+    }
+
+    ALWAYS_INLINE void insert(OrderId id, Order* order) {
+        if (UNLIKELY((size_ + 1) * 2 > slots_.size())) {
+            rehash(slots_.size() * 2);
+        }
+        for (size_t i = home(id);; i = (i + 1) & mask_) {
+            Slot& s = slots_[i];
+            if (s.order == nullptr) {
+                s.id = id;
+                s.order = order;
+                size_++;
+                return;
+            }
+            if (s.id == id) {
+                s.order = order;
+                return;
+            }
+        }
+    }
+
+    ALWAYS_INLINE Order* extract(OrderId id) noexcept {
+        for (size_t i = home(id);; i = (i + 1) & mask_) {
+            Slot& s = slots_[i];
+            if (s.order == nullptr) return nullptr;
+            if (s.id == id) {
+                Order* order = s.order;
+                remove_at(i);
+                return order;
+            }
+        }
+    }
+
+    ALWAYS_INLINE bool erase(OrderId id) noexcept { return extract(id) != nullptr; }
+
+    ALWAYS_INLINE void prefetch(OrderId id) const noexcept { PREFETCH(&slots_[home(id)]); }
+};
+
+// FlatOrderIndex whose table starts at Capacity slots instead of the
+// default (it still doubles as it fills): for books expected to hold few
+// orders, where a pre-sized table would dominate their footprint
+template <size_t Capacity>
+class SizedFlatOrderIndex : public FlatOrderIndex {
+public:
+    SizedFlatOrderIndex() : FlatOrderIndex(Capacity) {}
+};
+
+// Direct-mapped sliding window for dense, roughly monotonic ids (venue
+// sequence numbers, generate_dataset). Ids in [lo_, lo_ + W) map straight
+// to slot id & (W - 1). A newer id past the window slides it forward and
+// evicts the still-live ids it uncovers into a FlatOrderIndex, which also
+// holds any id that arrives below the window.
+class WindowOrderIndex {
+private:
+    std::vector<Order*> window_;
+    size_t mask_;
+    OrderId lo_;
+    size_t window_size_;  // live entries in window_
+    FlatOrderIndex overflow_;
+
+    ALWAYS_INLINE bool in_window(OrderId id) const noexcept {
+        return id - lo_ <= mask_;  // unsigned: ids below lo_ wrap high
+    }
+
+    void slide_to(OrderId new_lo) {
+        // Each slot is visited at most once per full window of advance
+        OrderId stop = (new_lo - lo_ > mask_) ? lo_ + mask_ + 1 : new_lo;
+        for (OrderId id = lo_; id != stop && window_size_ > 0; ++id) {
+            Order*& slot = window_[id & mask_];
+            if (slot != nullptr) {
+                overflow_.insert(id, slot);
+                slot = nullptr;
+                window_size_--;
+            }
+        }
+        lo_ = new_lo;
+    }
+
+public:
+    static constexpr size_t DEFAULT_WINDOW = 256 * 1024;
+
+    explicit WindowOrderIndex(size_t window = DEFAULT_WINDOW)
+        : window_(std::bit_ceil(window < 64 ? size_t(64) : window), nullptr),
+          mask_(window_.size() - 1), lo_(0), window_size_(0),
+          overflow_(FlatOrderIndex::DEFAULT_CAPACITY / 16) {}
+
+    size_t size() const noexcept { return window_size_ + overflow_.size(); }
+    bool empty() const noexcept { return size() == 0; }
+    size_t overflow_size() const noexcept { return overflow_.size(); }
+
+    ALWAYS_INLINE Order* find(OrderId id) const noexcept {
+        if (LIKELY(in_window(id))) return window_[id & mask_];
+        return overflow_.empty() ? nullptr : overflow_.find(id);
+    }
+
+    ALWAYS_INLINE void insert(OrderId id, Order* order) {
+        if (UNLIKELY(!in_window(id))) {
+            if (id < lo_) {
+                overflow_.insert(id, order);
+                return;
+            }
+            slide_to(id - mask_);
+        }
+        Order*& slot = window_[id & mask_];
+        window_size_ += (slot == nullptr);
+        slot = order;
+    }
+
+    ALWAYS_INLINE Order* extract(OrderId id) noexcept {
+        if (LIKELY(in_window(id))) {
+            Order*& slot = window_[id & mask_];
+            Order* order = slot;
+            window_size_ -= (order != nullptr);
+            slot = nullptr;
+            return order;
+        }
+        return overflow_.empty() ? nullptr : overflow_.extract(id);
+    }
+
+    ALWAYS_INLINE bool erase(OrderId id) noexcept { return extract(id) != nullptr; }
+
+    ALWAYS_INLINE void prefetch(OrderId id) const noexcept {
+        if (LIKELY(in_window(id))) {
+            PREFETCH(&window_[id & mask_]);
+        } else {
+            overflow_.prefetch(id);
+        }
+    }
+};
@@ -0,0 +1,202 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <new>
+#include "PriceLevel.h"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+struct PoolStats {
+    size_t in_use;            // live Orders
+    size_t high_water_mark;   // peak live Orders since construction
+    size_t capacity;          // Orders backed by committed chunks
+    size_t chunks;
+};
+
+// Slab allocator for Orders inside one reserved, ORDER_REGION_BYTES-aligned
+// address range (see PriceLevel.h), so every Order of a pool is a 32-bit
+// slot away from any other. Slot 0 is the null ref. Fixed-size chunks of
+// the range are committed as the pool grows and never move (Order* stays
+// valid for the life of the pool); a LIFO free list threaded through
+// next_in_level hands out the most recently released (cache-hot) slot
+// first. Committed memory is carved off with a bump pointer and is not
+// faulted in until first use. Exhausting the range throws std::bad_alloc,
+// like operator new.
+class OrderPool {
+public:
+    static constexpr size_t DEFAULT_CHUNK_ORDERS = 64 * 1024;
+    // Orders in the region's Order array (the whole region, or its first
+    // half with the hot/cold split), less the null slot
+    static constexpr size_t MAX_ORDERS =
+        (ENABLE_ORDER_HOT_COLD_SPLIT ? ORDER_REGION_BYTES / 2 : ORDER_REGION_BYTES) / sizeof(Order) - 1;
+
+private:
+    std::byte* region_;
+    Order* free_head_;
+    Order* bump_;
+    Order* bump_end_;
+    size_t chunk_orders_;
+    size_t chunks_;
+    size_t capacity_;
+    size_t in_use_;
+    size_t high_water_;
+
+    // Address space only (PROT_NONE / MEM_RESERVE): nothing is committed
+    // or counted against overcommit until add_chunk() opens it up
+    static std::byte* reserve_region() {
+        size_t span = 2 * ORDER_REGION_BYTES;
+#ifdef _WIN32
+        // A reservation cannot be trimmed, so find the aligned start inside
+        // an oversized one, release it and reserve just the aligned range
+        // there (another thread may take it in between: try again)
+        for (int attempt = 0; attempt < 8; ++attempt) {
+            void* raw = VirtualAlloc(nullptr, span, MEM_RESERVE, PAGE_NOACCESS);
+            if (raw == nullptr) {
+                throw std::bad_alloc();
+            }
+            auto start = reinterpret_cast<uintptr_t>(raw);
+            uintptr_t aligned = (start + ORDER_REGION_BYTES - 1) & ~uintptr_t(ORDER_REGION_BYTES - 1);
+            VirtualFree(raw, 0, MEM_RELEASE);
+            void* region = VirtualAlloc(reinterpret_cast<void*>(aligned), ORDER_REGION_BYTES, MEM_RESERVE, PAGE_NOACCESS);
+            if (region != nullptr) {
+                return static_cast<std::byte*>(region);
+            }
+        }
+        throw std::bad_alloc();
+#else
+        void* raw = mmap(nullptr, span, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (raw == MAP_FAILED) {
+            throw std::bad_alloc();
+        }
+        auto start = reinterpret_cast<uintptr_t>(raw);
+        uintptr_t aligned = (start + ORDER_REGION_BYTES - 1) & ~uintptr_t(ORDER_REGION_BYTES - 1);
+        if (aligned > start) {
+            munmap(raw, aligned - start);
+        }
+        munmap(reinterpret_cast<void*>(aligned + ORDER_REGION_BYTES), start + span - aligned - ORDER_REGION_BYTES);
+        return reinterpret_cast<std::byte*>(aligned);
+#endif
+    }
+
+    static void commit(void* begin, void* end) {
+#ifdef _WIN32
+        // MEM_COMMIT rounds out to whole pages itself
+        size_t bytes = static_cast<std::byte*>(end) - static_cast<std::byte*>(begin);
+        if (VirtualAlloc(begin, bytes, MEM_COMMIT, PAGE_READWRITE) == nullptr) {
+            throw std::bad_alloc();
+        }
+#else
+        auto page = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+        uintptr_t lo = reinterpret_cast<uintptr_t>(begin) & ~(page - 1);
+        uintptr_t hi = (reinterpret_cast<uintptr_t>(end) + page - 1) & ~(page - 1);
+        if (mprotect(reinterpret_cast<void*>(lo), hi - lo, PROT_READ | PROT_WRITE) != 0) {
+            throw std::bad_alloc();
+        }
+#endif
+    }
+
+    void add_chunk() {
+        size_t first = 1 + capacity_;
+        if (first > MAX_ORDERS) {
+            throw std::bad_alloc();
+        }
+        size_t count = std::min(chunk_orders_, MAX_ORDERS + 1 - first);
+        Order* orders = reinterpret_cast<Order*>(region_);
+        commit(orders + first, orders + first + count);
+        if constexpr (ENABLE_ORDER_HOT_COLD_SPLIT) {
+            OrderCold* cold = reinterpret_cast<OrderCold*>(region_ + ORDER_REGION_BYTES / 2);
+            commit(cold + first, cold + first + count);
+        }
+        bump_ = orders + first;
+        bump_end_ = bump_ + count;
+        capacity_ += count;
+        chunks_++;
+    }
+
+public:
+    explicit OrderPool(size_t chunk_orders = DEFAULT_CHUNK_ORDERS)
+        : region_(reserve_region()), free_head_(nullptr), bump_(nullptr), bump_end_(nullptr),
+          chunk_orders_(chunk_orders ? chunk_orders : DEFAULT_CHUNK_ORDERS),
+          chunks_(0), capacity_(0), in_use_(0), high_water_(0) {
+        add_chunk();
+    }
+
+    ~OrderPool() {
+#ifdef _WIN32
+        VirtualFree(region_, 0, MEM_RELEASE);
+#else
+        munmap(region_, ORDER_REGION_BYTES);
+#endif
+    }
+
+    OrderPool(const OrderPool&) = delete;
+    OrderPool& operator=(const OrderPool&) = delete;
+
+    ALWAYS_INLINE Order* allocate(OrderId id, Quantity qty) {
+        Order* slot;
+        if (LIKELY(free_head_ != nullptr)) {
+            slot = free_head_;
+            free_head_ = slot->next();
+        } else {
+            if (UNLIKELY(bump_ == bump_end_)) {
+                add_chunk();  // new chunk; existing Orders never move
+            }
+            slot = bump_++;
+        }
+        if (UNLIKELY(++in_use_ > high_water_)) {
+            high_water_ = in_use_;
+        }
+        return new (slot) Order(id, qty);
+    }
+
+    ALWAYS_INLINE void release(Order* order) noexcept {
+        order->next_in_level = free_head_ ? free_head_->ref() : 0;
+        free_head_ = order;
+        in_use_--;
+    }
+
+    // Release front..back, already linked through next_in_level (a retired
+    // level's queue), by splicing the run onto the free list
+    ALWAYS_INLINE void release_chain(Order* front, Order* back, size_t count) noexcept {
+        back->next_in_level = free_head_ ? free_head_->ref() : 0;
+        free_head_ = front;
+        in_use_ -= count;
+    }
+
+    PoolStats stats() const noexcept {
+        return PoolStats{in_use_, high_water_, capacity_, chunks_};
+    }
+};
+
+// Handle to an OrderPool owned elsewhere, with OrderPool's interface, so
+// several books draw Orders from one region instead of each reserving its
+// own (a book's Orders only need to share a region with each other, and
+// books in one pool share it the same way). The pool must outlive every
+// book using it, and all of them must run on one thread. stats() are the
+// whole pool's.
+class SharedOrderPool {
+private:
+    OrderPool* pool_;
+
+public:
+    explicit SharedOrderPool(OrderPool& pool) noexcept : pool_(&pool) {}
+
+    ALWAYS_INLINE Order* allocate(OrderId id, Quantity qty) { return pool_->allocate(id, qty); }
+    ALWAYS_INLINE void release(Order* order) noexcept { pool_->release(order); }
+    ALWAYS_INLINE void release_chain(Order* front, Order* back, size_t count) noexcept {
+        pool_->release_chain(front, back, count);
+    }
+    PoolStats stats() const noexcept { return pool_->stats(); }
+};
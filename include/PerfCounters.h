@@ -0,0 +1,174 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#ifdef __linux__
+#include <cerrno>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Hardware performance counters for the calling thread (Linux
+// perf_event_open), user space only. The events are opened as one group, so
+// a single read() returns all of them and they are scheduled together;
+// events the CPU (or VM) does not expose are skipped, and available() is
+// false if none could be opened (error() says why). Counts are scaled by
+// time_enabled / time_running if the kernel had to multiplex the group.
+//
+//   PerfCounters perf;
+//   perf.start();  ...work...  perf.stop();
+//   PerfSample s = perf.read();   // s.valid[i], s.values[i]
+enum class PerfEvent : uint8_t {
+    Cycles,
+    Instructions,
+    L1DMisses,      // L1 data cache read misses
+    LLCMisses,      // last-level cache misses
+    BranchMisses,
+    DTLBMisses,     // data TLB read misses
+};
+inline constexpr size_t PERF_EVENT_COUNT = 6;
+
+inline const char* perf_event_name(PerfEvent event) noexcept {
+    static const char* const names[PERF_EVENT_COUNT] = {
+        "cycles", "instructions", "l1d_misses", "llc_misses", "branch_misses", "dtlb_misses"};
+    return names[static_cast<size_t>(event)];
+}
+
+struct PerfSample {
+    uint64_t values[PERF_EVENT_COUNT] = {};
+    bool valid[PERF_EVENT_COUNT] = {};
+    bool multiplexed = false;   // counts were scaled up from partial running time
+
+    uint64_t operator[](PerfEvent event) const noexcept { return values[static_cast<size_t>(event)]; }
+
+    PerfSample& operator+=(const PerfSample& other) noexcept {
+        for (size_t i = 0; i < PERF_EVENT_COUNT; ++i) {
+            values[i] += other.values[i];
+            valid[i] = valid[i] || other.valid[i];
+        }
+        multiplexed = multiplexed || other.multiplexed;
+        return *this;
+    }
+
+    // this - earlier, for two reads of the same running group
+    PerfSample since(const PerfSample& earlier) const noexcept {
+        PerfSample delta = *this;
+        for (size_t i = 0; i < PERF_EVENT_COUNT; ++i) delta.values[i] -= earlier.values[i];
+        return delta;
+    }
+};
+
+class PerfCounters {
+private:
+    int fds_[PERF_EVENT_COUNT];
+    size_t group_pos_[PERF_EVENT_COUNT];   // position in the group read, if open
+    size_t opened_ = 0;
+    int leader_ = -1;
+    std::string error_;
+
+#ifdef __linux__
+    static void describe(PerfEvent event, perf_event_attr& attr) noexcept {
+        auto cache = [](uint64_t cache_id) {
+            return cache_id | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        };
+        switch (event) {
+            case PerfEvent::Cycles:       attr.type = PERF_TYPE_HARDWARE; attr.config = PERF_COUNT_HW_CPU_CYCLES; break;
+            case PerfEvent::Instructions: attr.type = PERF_TYPE_HARDWARE; attr.config = PERF_COUNT_HW_INSTRUCTIONS; break;
+            case PerfEvent::L1DMisses:    attr.type = PERF_TYPE_HW_CACHE; attr.config = cache(PERF_COUNT_HW_CACHE_L1D); break;
+            case PerfEvent::LLCMisses:    attr.type = PERF_TYPE_HARDWARE; attr.config = PERF_COUNT_HW_CACHE_MISSES; break;
+            case PerfEvent::BranchMisses: attr.type = PERF_TYPE_HARDWARE; attr.config = PERF_COUNT_HW_BRANCH_MISSES; break;
+            case PerfEvent::DTLBMisses:   attr.type = PERF_TYPE_HW_CACHE; attr.config = cache(PERF_COUNT_HW_CACHE_DTLB); break;
+        }
+    }
+#endif
+
+public:
+    PerfCounters() {
+        for (size_t i = 0; i < PERF_EVENT_COUNT; ++i) fds_[i] = -1;
+#ifdef __linux__
+        for (size_t i = 0; i < PERF_EVENT_COUNT; ++i) {
+            perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            describe(static_cast<PerfEvent>(i), attr);
+            attr.disabled = (leader_ < 0);   // members follow the leader
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED |
+                               PERF_FORMAT_TOTAL_TIME_RUNNING;
+            int fd = static_cast<int>(::syscall(SYS_perf_event_open, &attr, 0, -1, leader_, 0));
+            if (fd < 0) {
+                if (error_.empty()) {
+                    error_ = std::string(perf_event_name(static_cast<PerfEvent>(i))) + ": " + std::strerror(errno);
+                }
+                continue;
+            }
+            if (leader_ < 0) leader_ = fd;
+            fds_[i] = fd;
+            group_pos_[i] = opened_++;
+        }
+#else
+        error_ = "perf_event_open is Linux-only";
+#endif
+    }
+
+    ~PerfCounters() {
+#ifdef __linux__
+        for (int fd : fds_) {
+            if (fd >= 0) ::close(fd);
+        }
+#endif
+    }
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    bool available() const noexcept { return opened_ > 0; }
+    bool has(PerfEvent event) const noexcept { return fds_[static_cast<size_t>(event)] >= 0; }
+    // First event that failed to open (empty if all opened)
+    const std::string& error() const noexcept { return error_; }
+
+    // Zero and start the whole group
+    void start() noexcept {
+#ifdef __linux__
+        if (leader_ < 0) return;
+        ::ioctl(leader_, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ::ioctl(leader_, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+#endif
+    }
+
+    void stop() noexcept {
+#ifdef __linux__
+        if (leader_ >= 0) ::ioctl(leader_, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+#endif
+    }
+
+    // Counts since start() (valid while running too: one read() syscall)
+    PerfSample read() const noexcept {
+        PerfSample sample;
+#ifdef __linux__
+        if (leader_ < 0) return sample;
+        // {nr, time_enabled, time_running, values[nr]}
+        uint64_t buf[3 + PERF_EVENT_COUNT];
+        if (::read(leader_, buf, sizeof(buf)) < static_cast<ssize_t>(3 * sizeof(uint64_t))) return sample;
+        uint64_t enabled = buf[1];
+        uint64_t running = buf[2];
+        double scale = 1.0;
+        if (running > 0 && running < enabled) {
+            scale = static_cast<double>(enabled) / static_cast<double>(running);
+            sample.multiplexed = true;
+        }
+        for (size_t i = 0; i < PERF_EVENT_COUNT; ++i) {
+            if (fds_[i] < 0 || group_pos_[i] >= buf[0]) continue;
+            sample.values[i] = static_cast<uint64_t>(static_cast<double>(buf[3 + group_pos_[i]]) * scale);
+            sample.valid[i] = true;
+        }
+#endif
+        return sample;
+    }
+};
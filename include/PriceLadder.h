@@ -0,0 +1,483 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <limits>
+#include <functional>
+#include <map>
+#include <memory>
+#include <vector>
+#include "PriceLevel.h"
+#include "LevelPool.h"
+
+// Per-side price ordering: bids best-first descending, asks ascending.
+// crosses(limit, price): an order of side S limited at limit can trade
+// against a resting order of the opposite side at price. UNBOUNDED is the
+// limit that crosses every price (a market order's).
+template <Side S>
+struct SideTraits;
+
+template <>
+struct SideTraits<Side::Buy> {
+    using Compare = std::greater<Price>;
+    static constexpr Price UNBOUNDED = std::numeric_limits<Price>::max();
+    static constexpr bool better(Price a, Price b) noexcept { return a > b; }
+    static constexpr bool crosses(Price limit, Price price) noexcept { return price <= limit; }
+};
+
+template <>
+struct SideTraits<Side::Sell> {
+    using Compare = std::less<Price>;
+    static constexpr Price UNBOUNDED = std::numeric_limits<Price>::min();
+    static constexpr bool better(Price a, Price b) noexcept { return a < b; }
+    static constexpr bool crosses(Price limit, Price price) noexcept { return price >= limit; }
+};
+
+// Tree of price levels whose nodes (a PriceLevel each) come from a NodeArena
+template <Side S>
+using LevelTree = std::map<Price, PriceLevel, typename SideTraits<S>::Compare,
+                           ArenaAllocator<std::pair<const Price, PriceLevel>>>;
+
+// Reference backend: one red-black tree node per price level. A level that
+// empties within CacheTicks of the touch keeps its node in a small cache
+// (at most CacheTicks nodes, oldest evicted first), and the next level
+// opened takes a cached node back: re-keying and re-linking it, with no
+// allocation. CacheTicks = 0 frees every emptied node to the arena.
+template <Side S, size_t CacheTicks = 16>
+class MapBookSide {
+private:
+    using Tree = LevelTree<S>;
+
+    std::unique_ptr<NodeArena> arena_;   // declared first: outlives the tree
+    Tree levels_;
+    std::vector<typename Tree::node_type> cache_;   // oldest first
+    LevelStats stats_;
+
+    static constexpr bool near(Price a, Price b) noexcept {
+        return (a > b ? a - b : b - a) <= static_cast<Price>(CacheTicks);
+    }
+
+public:
+    MapBookSide()
+        : arena_(std::make_unique<NodeArena>()),
+          levels_(typename Tree::key_compare(), typename Tree::allocator_type(arena_.get())) {
+        cache_.reserve(CacheTicks);
+    }
+
+    bool empty() const noexcept { return levels_.empty(); }
+    size_t level_count() const noexcept { return levels_.size(); }
+
+    // Precondition for best_*: !empty()
+    Price best_price() const noexcept { return levels_.begin()->first; }
+    PriceLevel& best_level() noexcept { return levels_.begin()->second; }
+    const PriceLevel& best_level() const noexcept { return levels_.begin()->second; }
+
+    PriceLevel* find(Price price) noexcept {
+        auto it = levels_.find(price);
+        return it != levels_.end() ? &it->second : nullptr;
+    }
+
+    PriceLevel& get_or_create(Price price) {
+        auto it = levels_.lower_bound(price);
+        if (it != levels_.end() && it->first == price) {
+            return it->second;
+        }
+        stats_.created++;
+        if (!cache_.empty()) {
+            typename Tree::node_type node = std::move(cache_.back());
+            cache_.pop_back();
+            node.key() = price;
+            node.mapped() = PriceLevel(price, S);
+            stats_.cache_hits++;
+            return levels_.insert(it, std::move(node))->second;
+        }
+        return levels_.emplace_hint(it, price, PriceLevel(price, S))->second;
+    }
+
+    // Tree nodes cannot be located without walking the tree
+    void prefetch(Price) const noexcept {}
+
+    // Warm the level behind the best one (a sweep is retiring the best)
+    void prefetch_second() const noexcept {
+        if (levels_.size() > 1) {
+            PREFETCH(&std::next(levels_.begin())->second);
+        }
+    }
+
+    void erase(Price price) {
+        auto it = levels_.find(price);
+        if (it == levels_.end()) return;
+        stats_.destroyed++;
+        if constexpr (CacheTicks > 0) {
+            // Touch once this level is gone
+            Price touch = it != levels_.begin() ? levels_.begin()->first
+                        : std::next(it) != levels_.end() ? std::next(it)->first : price;
+            if (near(price, touch)) {
+                std::erase_if(cache_, [touch](const auto& node) { return !near(node.key(), touch); });
+                if (cache_.size() == CacheTicks) {
+                    cache_.erase(cache_.begin());
+                }
+                cache_.push_back(levels_.extract(it));
+                return;
+            }
+        }
+        levels_.erase(it);
+    }
+
+    LevelStats level_stats() const noexcept {
+        LevelStats stats = stats_;
+        stats.cached = cache_.size();
+        return stats;
+    }
+
+    // Visit levels in priority order (best first)
+    template <typename F>
+    void for_each(F&& f) const {
+        for (const auto& [price, level] : levels_) {
+            f(price, level);
+        }
+    }
+
+    // f(price, level) for the n best levels only; returns levels visited
+    template <typename F>
+    size_t for_each_best(size_t n, F&& f) const {
+        size_t visited = 0;
+        for (auto it = levels_.begin(); visited < n && it != levels_.end(); ++it, ++visited) {
+            f(it->first, it->second);
+        }
+        return visited;
+    }
+    
+    // Visit levels best first while f(price, level) returns true
+    template <typename F>
+    void for_each_until(F&& f) const {
+        for (const auto& [price, level] : levels_) {
+            if (!f(price, level)) return;
+        }
+    }
+};
+
+// Dense tick-indexed ladder: PriceLevels live in a contiguous array indexed
+// by (price - base_). A two-level occupancy bitmap finds the next best price
+// in a handful of word scans. Prices outside the window go to a small tree.
+// The window re-anchors on the touch whenever the best price leaves it.
+template <Side S>
+class PriceLadder {
+public:
+    static constexpr size_t DEFAULT_TICKS = 4096;
+
+private:
+    using Traits = SideTraits<S>;
+    static constexpr size_t NPOS = ~size_t(0);
+
+    std::vector<PriceLevel> levels_;
+    std::vector<uint64_t> occupancy_;   // 1 bit per slot
+    std::vector<uint64_t> summary_;     // 1 bit per non-zero occupancy_ word
+    size_t ticks_;
+    Price base_;                        // price of slot 0
+    size_t live_;                       // occupied slots
+    size_t best_slot_;                  // valid when live_ > 0
+
+    // Far-away outliers (always outside [base_, base_ + ticks_)), their
+    // tree nodes drawn from an arena declared ahead of the tree
+    std::unique_ptr<NodeArena> outlier_arena_;
+    LevelTree<S> outliers_;
+    LevelStats stats_;
+
+    ALWAYS_INLINE size_t slot_of(Price price) const noexcept {
+        // Unsigned wrap puts prices below base_ out of range as well
+        return static_cast<size_t>(static_cast<uint64_t>(price) - static_cast<uint64_t>(base_));
+    }
+
+    ALWAYS_INLINE Price price_of(size_t slot) const noexcept {
+        return base_ + static_cast<Price>(slot);
+    }
+
+    ALWAYS_INLINE bool test(size_t slot) const noexcept {
+        return (occupancy_[slot >> 6] >> (slot & 63)) & 1;
+    }
+
+    ALWAYS_INLINE void set(size_t slot) noexcept {
+        size_t w = slot >> 6;
+        occupancy_[w] |= uint64_t(1) << (slot & 63);
+        summary_[w >> 6] |= uint64_t(1) << (w & 63);
+    }
+
+    ALWAYS_INLINE void clear(size_t slot) noexcept {
+        size_t w = slot >> 6;
+        occupancy_[w] &= ~(uint64_t(1) << (slot & 63));
+        if (occupancy_[w] == 0) {
+            summary_[w >> 6] &= ~(uint64_t(1) << (w & 63));
+        }
+    }
+
+    // Lowest occupied slot >= from
+    size_t scan_up(size_t from) const noexcept {
+        if (from >= ticks_) return NPOS;
+        size_t w = from >> 6;
+        uint64_t bits = occupancy_[w] & (~uint64_t(0) << (from & 63));
+        if (bits) return (w << 6) + std::countr_zero(bits);
+
+        size_t next = w + 1;
+        if (next >= occupancy_.size()) return NPOS;
+        size_t sw = next >> 6;
+        uint64_t sbits = summary_[sw] & (~uint64_t(0) << (next & 63));
+        for (;;) {
+            if (sbits) {
+                size_t word = (sw << 6) + std::countr_zero(sbits);
+                return (word << 6) + std::countr_zero(occupancy_[word]);
+            }
+            if (++sw >= summary_.size()) return NPOS;
+            sbits = summary_[sw];
+        }
+    }
+
+    // Highest occupied slot <= from
+    size_t scan_down(size_t from) const noexcept {
+        if (from == NPOS) return NPOS;
+        size_t w = from >> 6;
+        uint64_t bits = occupancy_[w] & (~uint64_t(0) >> (63 - (from & 63)));
+        if (bits) return (w << 6) + 63 - std::countl_zero(bits);
+
+        if (w == 0) return NPOS;
+        size_t prev = w - 1;
+        size_t sw = prev >> 6;
+        uint64_t sbits = summary_[sw] & (~uint64_t(0) >> (63 - (prev & 63)));
+        for (;;) {
+            if (sbits) {
+                size_t word = (sw << 6) + 63 - std::countl_zero(sbits);
+                return (word << 6) + 63 - std::countl_zero(occupancy_[word]);
+            }
+            if (sw == 0) return NPOS;
+            sbits = summary_[--sw];
+        }
+    }
+
+    // Best occupied slot strictly worse than `slot`
+    ALWAYS_INLINE size_t next_worse(size_t slot) const noexcept {
+        if constexpr (S == Side::Buy) {
+            return slot == 0 ? NPOS : scan_down(slot - 1);
+        } else {
+            return scan_up(slot + 1);
+        }
+    }
+
+    ALWAYS_INLINE size_t first_slot() const noexcept {
+        if constexpr (S == Side::Buy) {
+            return scan_down(ticks_ - 1);
+        } else {
+            return scan_up(0);
+        }
+    }
+
+    ALWAYS_INLINE bool best_is_outlier() const noexcept {
+        if (LIKELY(outliers_.empty())) return false;
+        if (live_ == 0) return true;
+        return Traits::better(outliers_.begin()->first, price_of(best_slot_));
+    }
+
+    // Re-anchor the window so `center` sits mid-ladder. Levels that fall out
+    // of the new window move to the outlier tree and vice versa. Rare path
+    // (costs a walk of the moved levels' orders).
+    void recenter(Price center) {
+        std::vector<std::pair<Price, PriceLevel>> moved;
+        moved.reserve(live_);
+        for (size_t slot = scan_up(0); slot != NPOS; slot = scan_up(slot + 1)) {
+            moved.emplace_back(price_of(slot), levels_[slot]);
+            levels_[slot] = PriceLevel();
+        }
+        std::fill(occupancy_.begin(), occupancy_.end(), 0);
+        std::fill(summary_.begin(), summary_.end(), 0);
+        live_ = 0;
+
+        base_ = center - static_cast<Price>(ticks_ / 2);
+
+        for (auto it = outliers_.begin(); it != outliers_.end();) {
+            if (slot_of(it->first) < ticks_) {
+                moved.emplace_back(it->first, it->second);
+                it = outliers_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+
+        // Levels changed address: re-point their orders' level handles
+        for (auto& [price, level] : moved) {
+            size_t slot = slot_of(price);
+            if (slot < ticks_) {
+                levels_[slot] = level;
+                levels_[slot].rebind_orders();
+                set(slot);
+                live_++;
+            } else {
+                outliers_.emplace(price, level).first->second.rebind_orders();
+            }
+        }
+
+        if (live_ > 0) {
+            best_slot_ = first_slot();
+        }
+    }
+
+public:
+    explicit PriceLadder(size_t ticks = DEFAULT_TICKS)
+        : ticks_(std::bit_ceil(ticks < 64 ? size_t(64) : ticks)),
+          base_(std::numeric_limits<Price>::min()), live_(0), best_slot_(0),
+          outlier_arena_(std::make_unique<NodeArena>()),
+          outliers_(typename LevelTree<S>::key_compare(),
+                    typename LevelTree<S>::allocator_type(outlier_arena_.get())) {
+        levels_.resize(ticks_);
+        occupancy_.assign(ticks_ / 64, 0);
+        summary_.assign((occupancy_.size() + 63) / 64, 0);
+    }
+
+    bool empty() const noexcept { return live_ == 0 && outliers_.empty(); }
+    size_t level_count() const noexcept { return live_ + outliers_.size(); }
+    size_t outlier_count() const noexcept { return outliers_.size(); }
+
+    // Window slots are preallocated and reused in place, so there is nothing
+    // to cache: cache_hits and cached stay zero here
+    LevelStats level_stats() const noexcept { return stats_; }
+    size_t window_ticks() const noexcept { return ticks_; }
+    Price window_base() const noexcept { return base_; }
+
+    // Precondition for best_*: !empty()
+    Price best_price() const noexcept {
+        return best_is_outlier() ? outliers_.begin()->first : price_of(best_slot_);
+    }
+
+    PriceLevel& best_level() noexcept {
+        return best_is_outlier() ? outliers_.begin()->second : levels_[best_slot_];
+    }
+
+    const PriceLevel& best_level() const noexcept {
+        return best_is_outlier() ? outliers_.begin()->second : levels_[best_slot_];
+    }
+
+    // Warm the level (and its occupancy word) a later lookup will touch
+    ALWAYS_INLINE void prefetch(Price price) const noexcept {
+        size_t slot = slot_of(price);
+        if (LIKELY(slot < ticks_)) {
+            PREFETCH(&levels_[slot]);
+            PREFETCH(&occupancy_[slot >> 6]);
+        }
+    }
+
+    // Warm the level behind the best one (a sweep is retiring the best);
+    // only inside the window, where it is one bitmap scan away
+    ALWAYS_INLINE void prefetch_second() const noexcept {
+        if (live_ > 1 && !best_is_outlier()) {
+            size_t slot = next_worse(best_slot_);
+            if (LIKELY(slot != NPOS)) PREFETCH(&levels_[slot]);
+        }
+    }
+
+    PriceLevel* find(Price price) noexcept {
+        size_t slot = slot_of(price);
+        if (LIKELY(slot < ticks_)) {
+            return test(slot) ? &levels_[slot] : nullptr;
+        }
+        auto it = outliers_.find(price);
+        return it != outliers_.end() ? &it->second : nullptr;
+    }
+
+    PriceLevel& get_or_create(Price price) {
+        size_t slot = slot_of(price);
+        if (UNLIKELY(slot >= ticks_)) {
+            // Follow the touch: re-anchor when the ladder is unused or the
+            // new price would become the best; otherwise it is an outlier
+            if (live_ == 0 || Traits::better(price, price_of(best_slot_))) {
+                recenter(price);
+                slot = slot_of(price);
+            } else {
+                auto [it, inserted] = outliers_.try_emplace(price, price, S);
+                stats_.created += inserted;
+                return it->second;
+            }
+        }
+
+        if (!test(slot)) {
+            stats_.created++;
+            levels_[slot] = PriceLevel(price, S);
+            set(slot);
+            if (live_ == 0 || Traits::better(price_of(slot), price_of(best_slot_))) {
+                best_slot_ = slot;
+            }
+            live_++;
+        }
+        return levels_[slot];
+    }
+
+    void erase(Price price) {
+        size_t slot = slot_of(price);
+        if (UNLIKELY(slot >= ticks_)) {
+            stats_.destroyed += outliers_.erase(price);
+            return;
+        }
+        if (UNLIKELY(!test(slot))) return;
+
+        stats_.destroyed++;
+        clear(slot);
+        levels_[slot] = PriceLevel();
+        live_--;
+
+        if (slot == best_slot_ && live_ > 0) {
+            best_slot_ = next_worse(slot);
+        }
+
+        // Pull the outliers back in once the window has drained
+        if (UNLIKELY(live_ == 0 && !outliers_.empty())) {
+            recenter(outliers_.begin()->first);
+        }
+    }
+
+    // Visit levels in priority order (best first). Outliers can only sit
+    // beyond either edge of the window, so a three-part merge suffices.
+    template <typename F>
+    void for_each(F&& f) const {
+        auto it = outliers_.begin();
+        Price window_best = (S == Side::Buy) ? price_of(ticks_ - 1) : base_;
+        for (; it != outliers_.end() && Traits::better(it->first, window_best); ++it) {
+            f(it->first, it->second);
+        }
+        if (live_ > 0) {
+            for (size_t slot = best_slot_; slot != NPOS; slot = next_worse(slot)) {
+                f(price_of(slot), levels_[slot]);
+            }
+        }
+        for (; it != outliers_.end(); ++it) {
+            f(it->first, it->second);
+        }
+    }
+
+    // f(price, level) for the n best levels only; returns levels visited
+    template <typename F>
+    size_t for_each_best(size_t n, F&& f) const {
+        size_t visited = 0;
+        if (n == 0) return 0;
+        for_each_until([&](Price price, const PriceLevel& level) {
+            f(price, level);
+            return ++visited < n;
+        });
+        return visited;
+    }
+    
+    // Visit levels best first while f(price, level) returns true (same
+    // three-part merge as for_each)
+    template <typename F>
+    void for_each_until(F&& f) const {
+        auto it = outliers_.begin();
+        Price window_best = (S == Side::Buy) ? price_of(ticks_ - 1) : base_;
+        for (; it != outliers_.end() && Traits::better(it->first, window_best); ++it) {
+            if (!f(it->first, it->second)) return;
+        }
+        if (live_ > 0) {
+            for (size_t slot = best_slot_; slot != NPOS; slot = next_worse(slot)) {
+                if (!f(price_of(slot), levels_[slot])) return;
+            }
+        }
+        for (; it != outliers_.end(); ++it) {
+            if (!f(it->first, it->second)) return;
+        }
+    }
+};
@@ -0,0 +1,212 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include "Message.h"
+
+// Compiler hints for maximum optimization
+#ifdef __GNUC__
+#define LIKELY(x)   __builtin_expect(!!(x), 1)
+#define UNLIKELY(x) __builtin_expect(!!(x), 0)
+#define HOT         __attribute__((hot))
+#define ALWAYS_INLINE __attribute__((always_inline)) inline
+#define PREFETCH(addr) __builtin_prefetch(addr, 0, 3)
+#else
+#define LIKELY(x)   (x)
+#define UNLIKELY(x) (x)
+#define HOT
+#define ALWAYS_INLINE inline
+#define PREFETCH(addr)
+#endif
+
+using Price = int64_t;
+using OrderId = uint64_t;
+using Quantity = int64_t;
+
+// Slot of a resting Order in its pool region (0 = none)
+using OrderRef = uint32_t;
+
+// Configuration: keep what only reporting and cancels need (id, level
+// handle) in a cold array beside the Orders, so the matching loop walks
+// 16-byte records (qty + queue links), four to a cache line. Off: one
+// 32-byte record, two to a line.
+static constexpr bool ENABLE_ORDER_HOT_COLD_SPLIT = false;
+
+// Each OrderPool reserves one region of ORDER_REGION_BYTES aligned to its
+// size: Orders from the start and, with the split, their cold halves from
+// the midpoint at the same index. An Order resolves its queue links and its
+// cold half from its own address, with no pointer back to the pool.
+static constexpr size_t ORDER_REGION_BYTES = size_t(1) << 30;
+
+class PriceLevel;
+
+// Fields of a resting order the matching loop does not read
+struct OrderCold {
+    OrderId id;
+    // Level the order rests on (set by PriceLevel::add_order; stale once
+    // the order leaves it)
+    PriceLevel* level;
+};
+
+struct NoColdFields {};
+
+// Resting order: qty and intrusive queue links (32-bit slots in the same
+// pool region), plus id and level handle inline or split out. Price and
+// side are the level's. Only OrderPool constructs Orders with an id.
+struct alignas(ENABLE_ORDER_HOT_COLD_SPLIT ? 16 : 32) Order {
+    Quantity qty;
+    
+    // Intrusive list for O(1) remove
+    OrderRef next_in_level;
+    OrderRef prev_in_level;
+    
+    [[no_unique_address]] std::conditional_t<ENABLE_ORDER_HOT_COLD_SPLIT, NoColdFields, OrderCold> cold_;
+    
+    Order() noexcept : qty(0), next_in_level(0), prev_in_level(0) {}
+    
+    Order(OrderId id, Quantity qty) noexcept : qty(qty), next_in_level(0), prev_in_level(0) {
+        cold() = OrderCold{id, nullptr};
+    }
+    
+    Order(const Order&) = delete;
+    Order& operator=(const Order&) = delete;
+    
+    ALWAYS_INLINE OrderCold& cold() noexcept { return cold_of(this); }
+    ALWAYS_INLINE const OrderCold& cold() const noexcept { return cold_of(const_cast<Order*>(this)); }
+    
+    OrderId id() const noexcept { return cold().id; }
+    PriceLevel* level() const noexcept { return cold().level; }
+    
+    // The resting level's price and side (valid while the order rests)
+    Price price() const noexcept;
+    Side side() const noexcept;
+    
+    // This order's slot, and the Order at a slot of the same region
+    ALWAYS_INLINE OrderRef ref() const noexcept {
+        return static_cast<OrderRef>((reinterpret_cast<uintptr_t>(this) & (ORDER_REGION_BYTES - 1)) / sizeof(Order));
+    }
+    ALWAYS_INLINE Order* slot(OrderRef ref) const noexcept {
+        auto base = reinterpret_cast<uintptr_t>(this) & ~uintptr_t(ORDER_REGION_BYTES - 1);
+        return reinterpret_cast<Order*>(base) + ref;
+    }
+    ALWAYS_INLINE Order* next() const noexcept { return next_in_level ? slot(next_in_level) : nullptr; }
+    ALWAYS_INLINE Order* prev() const noexcept { return prev_in_level ? slot(prev_in_level) : nullptr; }
+
+private:
+    // Split: same index in the region's second half (a template so that the
+    // branch not taken is never compiled)
+    template <typename Self>
+    ALWAYS_INLINE static OrderCold& cold_of(Self* self) noexcept {
+        if constexpr (ENABLE_ORDER_HOT_COLD_SPLIT) {
+            return *reinterpret_cast<OrderCold*>(reinterpret_cast<std::byte*>(self) + ORDER_REGION_BYTES / 2);
+        } else {
+            return self->cold_;
+        }
+    }
+};
+static_assert(sizeof(Order) == (ENABLE_ORDER_HOT_COLD_SPLIT ? 16 : 32), "Order layout");
+static_assert(!ENABLE_ORDER_HOT_COLD_SPLIT || sizeof(OrderCold) == sizeof(Order),
+              "cold halves sit at the same index as their Orders");
+
+// Fast price level using intrusive doubly-linked list
+class PriceLevel {
+private:
+    Order* head_;
+    Quantity cached_qty_;  // Cache total quantity (always accurate)
+    Price price_;
+    OrderRef tail_;
+    uint32_t count_ : 31;
+    uint32_t sell_ : 1;
+    
+public:
+    PriceLevel() noexcept : head_(nullptr), cached_qty_(0), price_(0), tail_(0), count_(0), sell_(0) {}
+    
+    PriceLevel(Price price, Side side) noexcept
+        : head_(nullptr), cached_qty_(0), price_(price), tail_(0), count_(0), sell_(side == Side::Sell) {}
+    
+    bool empty() const noexcept { return head_ == nullptr; }
+    size_t size() const noexcept { return count_; }
+    Price price() const noexcept { return price_; }
+    Side side() const noexcept { return sell_ ? Side::Sell : Side::Buy; }
+    
+    Order* get_front() const noexcept { return head_; }
+    Order* get_back() const noexcept { return head_ ? head_->slot(tail_) : nullptr; }
+    
+    void add_order(Order* order) {
+        OrderRef ref = order->ref();
+        order->next_in_level = 0;
+        order->prev_in_level = tail_;
+        order->cold().level = this;
+        
+        if (UNLIKELY(head_ == nullptr)) {
+            head_ = order;
+        } else {
+            order->slot(tail_)->next_in_level = ref;
+        }
+        tail_ = ref;
+        
+        count_++;
+        cached_qty_ += order->qty;
+    }
+    
+    void remove_order(Order* order) {
+        if (UNLIKELY(order == nullptr)) return;
+        
+        cached_qty_ -= order->qty;
+        count_--;
+        
+        if (order->prev_in_level) {
+            order->slot(order->prev_in_level)->next_in_level = order->next_in_level;
+        } else {
+            head_ = order->next();
+        }
+        
+        if (order->next_in_level) {
+            order->slot(order->next_in_level)->prev_in_level = order->prev_in_level;
+        } else {
+            tail_ = order->prev_in_level;
+        }
+        
+        order->next_in_level = 0;
+        order->prev_in_level = 0;
+    }
+    
+    // Update cache when order quantity changes (partial fill)
+    void update_qty(Quantity old_qty, Quantity new_qty) {
+        cached_qty_ += (new_qty - old_qty);
+    }
+    
+    void remove_front() {
+        if (LIKELY(head_ != nullptr)) {
+            remove_order(head_);
+        }
+    }
+    
+    // Empty the level in one step and return the old front; the detached
+    // orders stay linked to each other (a sweep retiring the whole queue)
+    Order* take_all() noexcept {
+        Order* front = head_;
+        head_ = nullptr;
+        tail_ = 0;
+        count_ = 0;
+        cached_qty_ = 0;
+        return front;
+    }
+    
+    Quantity total_qty() const noexcept {
+        return cached_qty_;  // O(1) - always accurate with incremental updates
+    }
+    
+    // Point every order's level handle here after the level was copied to a
+    // new address (PriceLadder re-anchoring)
+    void rebind_orders() noexcept {
+        for (Order* o = head_; o != nullptr; o = o->next()) {
+            o->cold().level = this;
+        }
+    }
+};
+static_assert(sizeof(PriceLevel) == 32, "PriceLevel layout");
+
+inline Price Order::price() const noexcept { return level()->price(); }
+inline Side Order::side() const noexcept { return level()->side(); }
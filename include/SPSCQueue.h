@@ -0,0 +1,107 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+// Bounded lock-free single-producer/single-consumer ring.
+//
+// Both sides work on contiguous spans of slots in place, so the producer
+// can parse straight into the ring and the consumer can process messages
+// where they sit:
+//   producer: n = claim(ptr, max); fill ptr[0..n); publish(n);
+//   consumer: n = peek(ptr, max);  use ptr[0..n);  release(n);
+// claim() returning 0 means the ring is full (back-pressure); peek()
+// returning 0 means it is empty. Each side caches the other's index and
+// only re-reads the shared atomic when the cached view runs out.
+template <typename T>
+class SPSCQueue {
+private:
+    static constexpr size_t CACHE_LINE = 64;
+
+    std::vector<T> slots_;
+    size_t mask_;
+
+    alignas(CACHE_LINE) std::atomic<size_t> head_{0};  // next slot to read
+    size_t cached_tail_ = 0;                            // consumer's view of tail_
+
+    alignas(CACHE_LINE) std::atomic<size_t> tail_{0};  // next slot to write
+    size_t cached_head_ = 0;                            // producer's view of head_
+
+    alignas(CACHE_LINE) std::atomic<bool> closed_{false};
+
+public:
+    explicit SPSCQueue(size_t capacity)
+        : slots_(std::bit_ceil(capacity < 2 ? size_t(2) : capacity)),
+          mask_(slots_.size() - 1) {}
+
+    SPSCQueue(const SPSCQueue&) = delete;
+    SPSCQueue& operator=(const SPSCQueue&) = delete;
+
+    size_t capacity() const noexcept { return slots_.size(); }
+
+    // Producer: contiguous free slots starting at *out (at most max)
+    size_t claim(T*& out, size_t max) noexcept {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        size_t free = capacity() - (tail - cached_head_);
+        if (free == 0) {
+            cached_head_ = head_.load(std::memory_order_acquire);
+            free = capacity() - (tail - cached_head_);
+            if (free == 0) return 0;
+        }
+        size_t idx = tail & mask_;
+        size_t n = std::min({free, max, capacity() - idx});  // stop at the wrap
+        out = &slots_[idx];
+        return n;
+    }
+
+    void publish(size_t n) noexcept {
+        tail_.store(tail_.load(std::memory_order_relaxed) + n, std::memory_order_release);
+    }
+
+    // Consumer: contiguous readable slots starting at *out (at most max)
+    size_t peek(const T*& out, size_t max) noexcept {
+        size_t head = head_.load(std::memory_order_relaxed);
+        size_t avail = cached_tail_ - head;
+        if (avail == 0) {
+            cached_tail_ = tail_.load(std::memory_order_acquire);
+            avail = cached_tail_ - head;
+            if (avail == 0) return 0;
+        }
+        size_t idx = head & mask_;
+        size_t n = std::min({avail, max, capacity() - idx});
+        out = &slots_[idx];
+        return n;
+    }
+
+    void release(size_t n) noexcept {
+        head_.store(head_.load(std::memory_order_relaxed) + n, std::memory_order_release);
+    }
+
+    // Producer signals end of stream; consumer drains then sees drained()
+    void close() noexcept { closed_.store(true, std::memory_order_release); }
+
+    bool drained() const noexcept {
+        return closed_.load(std::memory_order_acquire) &&
+               head_.load(std::memory_order_relaxed) == tail_.load(std::memory_order_acquire);
+    }
+};
+
+// Back-off for a stalled ring endpoint: pause, and give up the core every 64
+// spins so the other side can run even when both share one CPU
+inline void spsc_backoff(uint64_t spins) noexcept {
+    if ((spins & 63) == 0) {
+        std::this_thread::yield();
+    } else {
+#if defined(__x86_64__) || defined(__i386__)
+        _mm_pause();
+#endif
+    }
+}
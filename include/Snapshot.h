@@ -0,0 +1,119 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "MappedFile.h"
+
+// Book checkpoint file (OrderBook::save_snapshot / load_snapshot):
+//   SnapshotHeader (64 bytes) followed by order_count SnapshotOrders: every
+//   resting order, bids then asks, levels best first and each level in time
+//   priority (front first). Side is implied by position (the first
+//   bid_orders records are bids). Fixed-width little-endian records, read in
+//   place from a mapping like BinaryFormat.h.
+static_assert(std::endian::native == std::endian::little,
+              "snapshot format is little-endian");
+
+static constexpr char SNAPSHOT_MAGIC[8] = {'L', 'O', 'B', 'S', 'N', 'A', 'P', '\0'};
+static constexpr uint32_t SNAPSHOT_VERSION = 1;
+
+struct SnapshotHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t record_size;     // sizeof(SnapshotOrder) at write time
+    uint64_t order_count;
+    uint64_t bid_orders;      // records [0, bid_orders) are bids
+    uint64_t sequence;        // messages applied; replay resumes at this input index
+    uint64_t total_trades;
+    uint64_t level_count;     // bid + ask levels
+    uint64_t reserved;
+};
+static_assert(sizeof(SnapshotHeader) == 64, "header layout is part of the format");
+
+struct SnapshotOrder {
+    uint64_t id;
+    int64_t  price;
+    int64_t  qty;             // open quantity
+};
+static_assert(sizeof(SnapshotOrder) == 24, "record layout is part of the format");
+
+// Maps a snapshot file and exposes its records in place. The records are
+// checked on open against what a saved book guarantees, so a load never
+// builds a book that breaks its own invariants.
+class SnapshotFile {
+private:
+    MappedFile file_;
+    const SnapshotHeader* header_ = nullptr;
+    const SnapshotOrder* records_ = nullptr;
+    std::string error_;
+
+    // Empty if the records can be restored as laid out: open quantities
+    // positive, each side best first (bid prices non-increasing, ask prices
+    // non-decreasing, so a level's records are contiguous), the touch not
+    // crossed, and no order id twice
+    static std::string check_records(const SnapshotOrder* records, uint64_t count, uint64_t bids) {
+        for (uint64_t i = 0; i < count; ++i) {
+            if (records[i].qty <= 0) {
+                return "order " + std::to_string(records[i].id) + " has no open quantity";
+            }
+            if (i != 0 && i != bids &&
+                (i < bids ? records[i].price > records[i - 1].price : records[i].price < records[i - 1].price)) {
+                return "record " + std::to_string(i) + " out of price-time order";
+            }
+        }
+        if (bids > 0 && bids < count && records[0].price >= records[bids].price) {
+            return "crossed book (bid " + std::to_string(records[0].price) + " >= ask " +
+                   std::to_string(records[bids].price) + ")";
+        }
+        std::vector<uint64_t> ids(count);
+        for (uint64_t i = 0; i < count; ++i) ids[i] = records[i].id;
+        std::sort(ids.begin(), ids.end());
+        auto dup = std::adjacent_find(ids.begin(), ids.end());
+        if (dup != ids.end()) {
+            return "duplicate order id " + std::to_string(*dup);
+        }
+        return {};
+    }
+
+public:
+    explicit SnapshotFile(const std::string& path) : file_(path) {
+        if (!file_.is_open()) {
+            error_ = "could not open " + path;
+            return;
+        }
+        if (file_.size() < sizeof(SnapshotHeader)) {
+            error_ = "file too small for header";
+            return;
+        }
+        const auto* header = reinterpret_cast<const SnapshotHeader*>(file_.data());
+        if (std::memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0) {
+            error_ = "bad magic (not a book snapshot)";
+            return;
+        }
+        if (header->version != SNAPSHOT_VERSION || header->record_size != sizeof(SnapshotOrder)) {
+            error_ = "unsupported version " + std::to_string(header->version);
+            return;
+        }
+        if (header->bid_orders > header->order_count ||
+            header->order_count > (file_.size() - sizeof(SnapshotHeader)) / sizeof(SnapshotOrder)) {
+            error_ = "truncated file (header claims " + std::to_string(header->order_count) + " orders)";
+            return;
+        }
+        const auto* records = reinterpret_cast<const SnapshotOrder*>(file_.data() + sizeof(SnapshotHeader));
+        error_ = check_records(records, header->order_count, header->bid_orders);
+        if (!error_.empty()) return;
+        header_ = header;
+        records_ = records;
+    }
+
+    bool is_valid() const noexcept { return header_ != nullptr; }
+    const std::string& error() const noexcept { return error_; }
+
+    const SnapshotHeader& header() const noexcept { return *header_; }
+    size_t size() const noexcept { return header_ ? header_->order_count : 0; }
+    const SnapshotOrder* begin() const noexcept { return records_; }
+    const SnapshotOrder* end() const noexcept { return records_ + size(); }
+};
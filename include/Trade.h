@@ -1,13 +1,13 @@
 #pragma once
 
 #include <cstdint>
-#include <chrono>
 
 struct Trade {
     uint64_t buy_id;
     uint64_t sell_id;
     int64_t  price;
     int64_t  qty;
-    std::chrono::steady_clock::time_point ts;
+    uint64_t ts_ns;     // event time: ts_ns of the aggressing message
+    uint64_t match_ts;  // engine clock at match (see Clock.h; 0 if disabled)
 };
 
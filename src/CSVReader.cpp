@@ -1,12 +1,99 @@
 #include "CSVReader.h"
+#include "MappedFile.h"
 #include <sstream>
 #include <iostream>
 #include <algorithm>
+#include <bit>
+#include <cstring>
+
+namespace {
+
+inline bool is_digit(char c) {
+    return static_cast<unsigned char>(c - '0') < 10;
+}
+
+inline void skip_blank(const char*& p, const char* end) {
+    while (p < end && (*p == ' ' || *p == '\t')) ++p;
+}
+
+// Eight ASCII digits at p -> value, using SWAR on one 64-bit load.
+// Returns false if any of the eight bytes is not a digit.
+inline bool parse_eight_digits(const char* p, uint64_t& out) {
+    uint64_t chunk;
+    std::memcpy(&chunk, p, 8);
+    if ((chunk & 0xF0F0F0F0F0F0F0F0ULL) != 0x3030303030303030ULL ||
+        ((chunk + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) != 0x3030303030303030ULL) {
+        return false;
+    }
+    chunk -= 0x3030303030303030ULL;
+    chunk = (chunk * 10) + (chunk >> 8);  // pairs
+    chunk = (((chunk & 0x000000FF000000FFULL) * (100 + (1000000ULL << 32))) +
+             (((chunk >> 16) & 0x000000FF000000FFULL) * (1 + (10000ULL << 32)))) >> 32;
+    out = chunk;
+    return true;
+}
+
+inline bool parse_uint(const char*& p, const char* end, uint64_t& out) {
+    const char* start = p;
+    uint64_t value = 0;
+    if constexpr (std::endian::native == std::endian::little) {
+        uint64_t eight;
+        while (end - p >= 8 && parse_eight_digits(p, eight)) {
+            value = value * 100000000ULL + eight;
+            p += 8;
+        }
+    }
+    while (p < end && is_digit(*p)) {
+        value = value * 10 + static_cast<uint64_t>(*p - '0');
+        ++p;
+    }
+    if (p - start > 19) {
+        // Past 19 digits the value may have wrapped: redo it with overflow
+        // checks (the stream reader's stoull rejects what does not fit)
+        value = 0;
+        for (const char* d = start; d != p; ++d) {
+            uint64_t digit = static_cast<uint64_t>(*d - '0');
+            if (value > (UINT64_MAX - digit) / 10) return false;
+            value = value * 10 + digit;
+        }
+    }
+    out = value;
+    return p != start;
+}
+
+inline bool parse_int(const char*& p, const char* end, int64_t& out) {
+    bool negative = (p < end && *p == '-');
+    if (negative) ++p;
+    uint64_t magnitude;
+    if (!parse_uint(p, end, magnitude)) return false;
+    if (magnitude > static_cast<uint64_t>(INT64_MAX) + negative) return false;
+    out = static_cast<int64_t>(negative ? 0 - magnitude : magnitude);
+    return true;
+}
+
+// Move past trailing blanks and the ',' ending the current field
+inline bool next_field(const char*& p, const char* end) {
+    skip_blank(p, end);
+    if (p >= end || *p != ',') return false;
+    ++p;
+    skip_blank(p, end);
+    return true;
+}
+
+// Skip the rest of a text token (up to ',' or end of line)
+inline void skip_token(const char*& p, const char* end) {
+    const char* comma = static_cast<const char*>(std::memchr(p, ',', end - p));
+    p = comma ? comma : end;
+}
+
+}  // namespace
 
 MsgType CSVReader::parse_msg_type(const std::string& s) {
     if (s == "NewLimit") return MsgType::NewLimit;
     if (s == "NewMarket") return MsgType::NewMarket;
     if (s == "Cancel") return MsgType::Cancel;
+    if (s == "Modify") return MsgType::Modify;
+    if (s == "CancelReplace") return MsgType::CancelReplace;
     return MsgType::NewLimit;  // default
 }
 
@@ -16,6 +103,13 @@ Side CSVReader::parse_side(const std::string& s) {
     return Side::Buy;  // default
 }
 
+TimeInForce CSVReader::parse_tif(const std::string& s) {
+    if (s == "IOC") return TimeInForce::IOC;
+    if (s == "FOK") return TimeInForce::FOK;
+    if (s == "PostOnly") return TimeInForce::PostOnly;
+    return TimeInForce::GTC;  // default
+}
+
 std::vector<Msg> CSVReader::read_messages(const std::string& filename) {
     std::vector<Msg> messages;
     std::ifstream file(filename);
@@ -64,14 +158,16 @@ std::vector<Msg> CSVReader::read_messages(const std::string& filename) {
         
         Msg msg;
         try {
-            // ts_ns,MsgType,Side,OrderId,Price,Qty
-            // We ignore ts_ns for MVP logic (just process in order)
+            // ts_ns,MsgType,Side,OrderId,Price,Qty[,Symbol[,Tif]]
+            msg.ts_ns = std::stoull(tokens[0]);
             msg.type = parse_msg_type(tokens[1]);
             msg.side = parse_side(tokens[2]);
             msg.id = std::stoull(tokens[3]);
             msg.price = std::stoll(tokens[4]);
             msg.qty = std::stoll(tokens[5]);
-            msg.ts = std::chrono::steady_clock::now();
+            msg.symbol = (tokens.size() > 6 && !tokens[6].empty())
+                ? static_cast<uint32_t>(std::stoul(tokens[6])) : 0;
+            msg.tif = tokens.size() > 7 ? parse_tif(tokens[7]) : TimeInForce::GTC;
             
             messages.push_back(msg);
         } catch (const std::exception& e) {
@@ -84,3 +180,163 @@ std::vector<Msg> CSVReader::read_messages(const std::string& filename) {
     return messages;
 }
 
+CSVReader::LineStatus CSVReader::parse_line(const char*& p, const char* end, Msg& msg) {
+    const char* line_end = static_cast<const char*>(std::memchr(p, '\n', end - p));
+    const char* q = p;
+    const char* e = line_end ? line_end : end;
+    p = line_end ? line_end + 1 : end;
+    
+    if (e > q && e[-1] == '\r') --e;
+    skip_blank(q, e);
+    if (q == e || *q == '#') {
+        return LineStatus::Skip;
+    }
+    
+    // ts_ns (a header row fails here)
+    if (!parse_uint(q, e, msg.ts_ns) || !next_field(q, e)) return LineStatus::Malformed;
+    
+    // MsgType: recognized by first bytes (NewLimit / NewMarket / Cancel /
+    // Modify / CancelReplace)
+    if (q == e) return LineStatus::Malformed;
+    if (*q == 'C') {
+        msg.type = (e - q > 6 && q[6] == 'R') ? MsgType::CancelReplace : MsgType::Cancel;
+    } else if (*q == 'M') {
+        msg.type = MsgType::Modify;
+    } else if (*q == 'N' && e - q > 3 && q[3] == 'M') {
+        msg.type = MsgType::NewMarket;
+    } else {
+        msg.type = MsgType::NewLimit;  // default
+    }
+    skip_token(q, e);
+    if (!next_field(q, e)) return LineStatus::Malformed;
+    
+    // Side: Buy / Sell
+    msg.side = (q < e && *q == 'S') ? Side::Sell : Side::Buy;
+    skip_token(q, e);
+    if (!next_field(q, e)) return LineStatus::Malformed;
+    
+    if (!parse_uint(q, e, msg.id) || !next_field(q, e)) return LineStatus::Malformed;
+    if (!parse_int(q, e, msg.price) || !next_field(q, e)) return LineStatus::Malformed;
+    if (!parse_int(q, e, msg.qty)) return LineStatus::Malformed;
+    
+    // Optional instrument id, then optional time in force (IOC / FOK /
+    // PostOnly, recognized by first byte; anything else is GTC)
+    msg.symbol = 0;
+    msg.tif = TimeInForce::GTC;
+    if (next_field(q, e)) {
+        uint64_t symbol;
+        if (q < e && *q != ',') {
+            if (!parse_uint(q, e, symbol) || symbol > UINT32_MAX) return LineStatus::Malformed;
+            msg.symbol = static_cast<uint32_t>(symbol);
+        }
+        if (next_field(q, e) && q < e) {
+            msg.tif = *q == 'I' ? TimeInForce::IOC
+                    : *q == 'F' ? TimeInForce::FOK
+                    : *q == 'P' ? TimeInForce::PostOnly : TimeInForce::GTC;
+        }
+    }
+    
+    return LineStatus::Message;
+}
+
+std::vector<Msg> CSVReader::read_messages_mmap(const std::string& filename) {
+    MappedFile file(filename);
+    if (!file.is_open()) {
+        std::cerr << "Error: Could not open file " << filename << std::endl;
+        return {};
+    }
+    
+    const char* p = file.begin();
+    const char* end = file.end();
+    
+    // Capacity from the line count, so appends never reallocate. Slots are
+    // not value-initialized up front: each Msg is parsed into a local and
+    // copied in once, and the only pass over the output is that append.
+    size_t max_lines = static_cast<size_t>(std::count(p, end, '\n')) + 1;
+    std::vector<Msg> messages;
+    messages.reserve(max_lines);
+    
+    size_t malformed = 0;
+    bool first_line = true;
+    Msg msg;
+    
+    while (p < end) {
+        LineStatus status = parse_line(p, end, msg);
+        if (status == LineStatus::Message) {
+            messages.push_back(msg);
+        } else if (status == LineStatus::Malformed && !first_line) {
+            malformed++;  // an un-commented header row is expected once
+        }
+        if (status != LineStatus::Skip) {
+            first_line = false;
+        }
+    }
+    
+    if (malformed > 0) {
+        std::cerr << "Warning: skipped " << malformed << " malformed lines in " << filename << std::endl;
+    }
+    
+    return messages;
+}
+
+CSVStreamReader::CSVStreamReader(const std::string& filename, size_t buffer_bytes)
+    : file_(filename, std::ios::binary), buffer_(buffer_bytes),
+      begin_(0), limit_(0), end_(0), eof_(false), first_line_(true), malformed_(0) {
+    if (!file_.is_open()) {
+        std::cerr << "Error: Could not open file " << filename << std::endl;
+    }
+}
+
+bool CSVStreamReader::refill() {
+    if (eof_) return false;
+    
+    // Keep the partial last line, read behind it
+    size_t tail = end_ - begin_;
+    if (tail == buffer_.size()) {
+        // A single line longer than the whole buffer: drop it
+        malformed_++;
+        tail = 0;
+    } else if (tail > 0) {
+        std::memmove(buffer_.data(), buffer_.data() + begin_, tail);
+    }
+    begin_ = 0;
+    
+    file_.read(buffer_.data() + tail, static_cast<std::streamsize>(buffer_.size() - tail));
+    end_ = tail + static_cast<size_t>(file_.gcount());
+    eof_ = file_.eof() || file_.gcount() == 0;
+    
+    // Parse only complete lines unless this is the end of the file
+    limit_ = end_;
+    if (!eof_) {
+        while (limit_ > 0 && buffer_[limit_ - 1] != '\n') --limit_;
+    }
+    return true;
+}
+
+size_t CSVStreamReader::next_batch(Msg* out, size_t max) {
+    size_t n = 0;
+    
+    while (n < max) {
+        if (begin_ >= limit_) {
+            if (!refill()) break;
+            continue;
+        }
+        
+        const char* p = buffer_.data() + begin_;
+        const char* limit = buffer_.data() + limit_;
+        while (n < max && p < limit) {
+            CSVReader::LineStatus status = CSVReader::parse_line(p, limit, out[n]);
+            if (status == CSVReader::LineStatus::Message) {
+                n++;
+            } else if (status == CSVReader::LineStatus::Malformed && !first_line_) {
+                malformed_++;
+            }
+            if (status != CSVReader::LineStatus::Skip) {
+                first_line_ = false;
+            }
+        }
+        begin_ = static_cast<size_t>(p - buffer_.data());
+    }
+    
+    return n;
+}
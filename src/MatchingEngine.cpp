@@ -0,0 +1,174 @@
+#include "MatchingEngine.h"
+#include <algorithm>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+template class BasicOrderBook<NullEventHandler, ShardBookPolicy>;
+
+MatchingEngine::MatchingEngine(size_t workers, size_t queue_capacity, bool pin_threads)
+    : symbol_limit_(0), rejected_(0), running_(true) {
+    workers = std::clamp<size_t>(workers, 1, MAX_SYMBOLS);
+    workers_.reserve(workers);
+    for (size_t i = 0; i < workers; ++i) {
+        workers_.push_back(std::make_unique<Worker>(queue_capacity));
+    }
+    
+    // Pin worker i to CPU i+1, leaving CPU 0 to the dispatcher (only when
+    // there is more than one CPU to go around)
+    unsigned cpus = std::thread::hardware_concurrency();
+    bool pin = pin_threads && cpus > 1;
+    for (size_t i = 0; i < workers; ++i) {
+        int cpu = pin ? static_cast<int>((i + 1) % cpus) : -1;
+        workers_[i]->thread = std::thread(&MatchingEngine::run_worker, this, i, cpu);
+    }
+}
+
+MatchingEngine::~MatchingEngine() {
+    stop();
+}
+
+void MatchingEngine::run_worker(size_t index, int cpu) {
+#ifdef __linux__
+    if (cpu >= 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);  // best effort
+    }
+#else
+    (void)cpu;
+#endif
+    
+    Worker& worker = *workers_[index];
+    const size_t stride = workers_.size();
+    uint32_t last_symbol = UINT32_MAX;
+    ShardBook* last_book = nullptr;
+    uint64_t spins = 0;
+    
+    for (;;) {
+        const Msg* batch;
+        size_t n = worker.queue.peek(batch, SUBMIT_BATCH);
+        if (n == 0) {
+            if (worker.queue.drained()) break;
+            worker.idle_spins++;
+            spsc_backoff(++spins);
+            continue;
+        }
+        
+        for (size_t k = 0; k < n; ++k) {
+            const Msg& msg = batch[k];
+            if (UNLIKELY(msg.symbol != last_symbol)) {
+                size_t slot = msg.symbol / stride;
+                if (slot >= worker.books.size()) worker.books.resize(slot + 1);
+                std::unique_ptr<ShardBook>& book = worker.books[slot];
+                if (!book) book = std::make_unique<ShardBook>(worker.orders);
+                last_book = book.get();
+                last_symbol = msg.symbol;
+            }
+            last_book->process_message(msg);
+        }
+        worker.messages.store(worker.messages.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+        worker.queue.release(n);
+    }
+}
+
+MatchingEngine::Worker* MatchingEngine::stage(const Msg& msg) {
+    if (UNLIKELY(msg.symbol >= MAX_SYMBOLS || !running_)) {
+        rejected_++;
+        return nullptr;
+    }
+    symbol_limit_ = std::max(symbol_limit_, msg.symbol + 1);
+    
+    Worker& worker = *workers_[msg.symbol % workers_.size()];
+    if (UNLIKELY(worker.staged_count == worker.staged_room)) {
+        publish_staged(worker);
+        uint64_t spins = 0;
+        while ((worker.staged_room = worker.queue.claim(worker.staged, SUBMIT_BATCH)) == 0) {
+            worker.submit_stalls++;
+            spsc_backoff(++spins);
+        }
+    }
+    worker.staged[worker.staged_count++] = msg;
+    return &worker;
+}
+
+bool MatchingEngine::submit(const Msg& msg) {
+    Worker* worker = stage(msg);
+    if (UNLIKELY(worker == nullptr)) return false;
+    publish_staged(*worker);
+    return true;
+}
+
+size_t MatchingEngine::submit(const Msg* msgs, size_t count) {
+    size_t accepted = 0;
+    for (size_t i = 0; i < count; ++i) {
+        accepted += (stage(msgs[i]) != nullptr);
+    }
+    flush();
+    return accepted;
+}
+
+// Publish the filled part of the claimed span; the rest stays claimed
+void MatchingEngine::publish_staged(Worker& worker) {
+    if (worker.staged_count > 0) {
+        worker.queue.publish(worker.staged_count);
+        worker.staged += worker.staged_count;
+        worker.staged_room -= worker.staged_count;
+        worker.staged_count = 0;
+    }
+}
+
+void MatchingEngine::flush() {
+    for (auto& worker : workers_) {
+        publish_staged(*worker);
+    }
+}
+
+void MatchingEngine::stop() {
+    if (!running_) return;
+    flush();
+    for (auto& worker : workers_) {
+        worker->queue.close();
+    }
+    for (auto& worker : workers_) {
+        worker->thread.join();
+    }
+    running_ = false;
+}
+
+size_t MatchingEngine::symbol_count() const noexcept {
+    size_t count = 0;
+    for (const auto& worker : workers_) {
+        for (const auto& book : worker->books) count += (book != nullptr);
+    }
+    return count;
+}
+
+WorkerStats MatchingEngine::worker_stats(size_t index) const noexcept {
+    const Worker& worker = *workers_[index];
+    WorkerStats stats;
+    stats.messages = worker.messages.load(std::memory_order_relaxed);
+    stats.books = 0;
+    for (const auto& book : worker.books) stats.books += (book != nullptr);
+    stats.idle_spins = worker.idle_spins;
+    stats.submit_stalls = worker.submit_stalls;
+    stats.orders = worker.orders.stats();
+    return stats;
+}
+
+uint64_t MatchingEngine::processed() const noexcept {
+    uint64_t total = 0;
+    for (const auto& worker : workers_) {
+        total += worker->messages.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+const ShardBook* MatchingEngine::book(uint32_t symbol) const noexcept {
+    const Worker& worker = *workers_[symbol % workers_.size()];
+    size_t slot = symbol / workers_.size();
+    return slot < worker.books.size() ? worker.books[slot].get() : nullptr;
+}
@@ -0,0 +1,116 @@
+#include "BinaryFormat.h"
+#include "CSVReader.h"
+#include "MappedFile.h"
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+// CSV -> fixed-width binary message file (see BinaryFormat.h)
+int main(int argc, char* argv[]) {
+    std::string input;
+    std::string output;
+    std::string symbol;
+    int64_t tick_size = 1;
+    int64_t lot_size = 1;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--symbol") == 0 && i + 1 < argc) {
+            symbol = argv[++i];
+        } else if (strcmp(argv[i], "--tick-size") == 0 && i + 1 < argc) {
+            tick_size = std::strtoll(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--lot-size") == 0 && i + 1 < argc) {
+            lot_size = std::strtoll(argv[++i], nullptr, 10);
+        } else if (input.empty()) {
+            input = argv[i];
+        } else if (output.empty()) {
+            output = argv[i];
+        }
+    }
+
+    if (input.empty() || output.empty()) {
+        std::cerr << "Usage: " << argv[0] << " <input.csv> <output.bin>"
+                  << " [--symbol <name>] [--tick-size <n>] [--lot-size <n>]" << std::endl;
+        return 1;
+    }
+
+    auto start_time = std::chrono::steady_clock::now();
+
+    MappedFile csv(input);
+    if (!csv.is_open()) {
+        std::cerr << "Error: Could not open file " << input << std::endl;
+        return 1;
+    }
+
+    std::ofstream out(output, std::ios::binary);
+    if (!out.is_open()) {
+        std::cerr << "Error: Could not open file " << output << std::endl;
+        return 1;
+    }
+
+    BinaryFileHeader header{};
+    std::memcpy(header.magic, BINARY_MAGIC, sizeof(BINARY_MAGIC));
+    header.version = BINARY_VERSION;
+    header.record_size = sizeof(BinaryMsgRecord);
+    std::strncpy(header.symbol, symbol.c_str(), sizeof(header.symbol) - 1);
+    header.tick_size = tick_size;
+    header.lot_size = lot_size;
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));  // count patched below
+
+    // Records are staged in a large buffer and written in blocks
+    const size_t BATCH_RECORDS = 64 * 1024;
+    std::vector<BinaryMsgRecord> batch;
+    batch.reserve(BATCH_RECORDS);
+
+    const char* p = csv.begin();
+    const char* end = csv.end();
+    uint64_t count = 0;
+    uint64_t malformed = 0;
+    bool first_line = true;
+    Msg msg{};
+
+    while (p < end) {
+        CSVReader::LineStatus status = CSVReader::parse_line(p, end, msg);
+        if (status == CSVReader::LineStatus::Message) {
+            batch.push_back(to_binary_record(msg));
+            if (batch.size() == BATCH_RECORDS) {
+                out.write(reinterpret_cast<const char*>(batch.data()), batch.size() * sizeof(BinaryMsgRecord));
+                count += batch.size();
+                batch.clear();
+            }
+        } else if (status == CSVReader::LineStatus::Malformed && !first_line) {
+            malformed++;
+        }
+        if (status != CSVReader::LineStatus::Skip) {
+            first_line = false;
+        }
+    }
+    out.write(reinterpret_cast<const char*>(batch.data()), batch.size() * sizeof(BinaryMsgRecord));
+    count += batch.size();
+
+    header.msg_count = count;
+    out.seekp(0);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.close();
+
+    if (!out) {
+        std::cerr << "Error: failed writing " << output << std::endl;
+        return 1;
+    }
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start_time).count();
+
+    if (malformed > 0) {
+        std::cerr << "Warning: skipped " << malformed << " malformed lines" << std::endl;
+    }
+    std::cout << "Converted " << count << " messages in " << elapsed << " ms" << std::endl;
+    std::cout << "Output file: " << output << " ("
+              << std::fixed << std::setprecision(2)
+              << ((sizeof(BinaryFileHeader) + count * sizeof(BinaryMsgRecord)) / (1024.0 * 1024.0))
+              << " MB)" << std::endl;
+
+    return 0;
+}
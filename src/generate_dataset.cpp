@@ -33,6 +33,24 @@ int main(int argc, char* argv[]) {
         if (num_messages <= 0) num_messages = 10'000'000;
     }
     
+    // Multi-symbol datasets: each message gets a uniformly random symbol id
+    // in a 7th column; cancels carry the symbol of the order they cancel
+    uint32_t num_symbols = 1;
+    if (argc > 2) {
+        num_symbols = static_cast<uint32_t>(std::strtoul(argv[2], nullptr, 10));
+        if (num_symbols == 0) num_symbols = 1;
+    }
+    const bool multi_symbol = num_symbols > 1;
+    
+    // Quote-update flow: this percentage of messages amends a random live
+    // order instead (3 in 4 Modify, 1 in 4 CancelReplace; price nudged by up
+    // to 2 ticks, new size). 0 keeps the classic mix.
+    uint64_t modify_pct = 0;
+    if (argc > 3) {
+        modify_pct = std::strtoull(argv[3], nullptr, 10);
+        if (modify_pct > 100) modify_pct = 100;
+    }
+    
     // Fast random number generator (xoshiro-style)
     uint64_t rng_state[4] = {42, 0x1234567890ABCDEFULL, 0xFEDCBA0987654321ULL, 0xABCDEF0123456789ULL};
     
@@ -62,6 +80,7 @@ int main(int argc, char* argv[]) {
         uint64_t id;
         int8_t side;  // 0=Buy, 1=Sell
         int64_t price;
+        uint32_t symbol;
         bool valid;
     };
     OrderSlot* orders = new OrderSlot[MAX_ORDERS];
@@ -70,9 +89,14 @@ int main(int argc, char* argv[]) {
     
     // Create output filename
     std::filesystem::create_directories("data");
-    std::string filename = "data/large_dataset_" + std::to_string(num_messages / 1000) + "k.csv";
+    std::string filename = "data/large_dataset_" + std::to_string(num_messages / 1000) + "k"
+        + (multi_symbol ? "_" + std::to_string(num_symbols) + "sym" : "")
+        + (modify_pct > 0 ? "_mod" + std::to_string(modify_pct) : "") + ".csv";
     
-    std::cout << "Generating " << num_messages << " messages..." << std::endl;
+    std::cout << "Generating " << num_messages << " messages";
+    if (multi_symbol) std::cout << " over " << num_symbols << " symbols";
+    if (modify_pct > 0) std::cout << " (" << modify_pct << "% amends)";
+    std::cout << "..." << std::endl;
     
     auto start_time = std::chrono::steady_clock::now();
     
@@ -84,7 +108,12 @@ int main(int argc, char* argv[]) {
     }
     
     // Write header
-    file.write("# ts_ns,MsgType,Side,OrderId,Price,Qty\n", 38);
+    if (multi_symbol) {
+        static const char header[] = "# ts_ns,MsgType,Side,OrderId,Price,Qty,Symbol\n";
+        file.write(header, sizeof(header) - 1);
+    } else {
+        file.write("# ts_ns,MsgType,Side,OrderId,Price,Qty\n", 38);
+    }
     
     // Huge buffer for maximum performance (128MB)
     const size_t buffer_size = 128 * 1024 * 1024;
@@ -96,12 +125,37 @@ int main(int argc, char* argv[]) {
     char num_buf_id[32];
     char num_buf_qty[32];
     char num_buf_price[32];
+    char num_buf_symbol[16];
+    
+    // Line terminator: ",symbol\n" for multi-symbol datasets, "\n" otherwise
+    auto end_line = [&](char* p, uint32_t symbol) -> char* {
+        if (multi_symbol) {
+            *p++ = ',';
+            char* sym_end = num_buf_symbol + sizeof(num_buf_symbol);
+            char* sym_start = fast_itoa(symbol, sym_end);
+            std::memcpy(p, sym_start, sym_end - sym_start);
+            p += sym_end - sym_start;
+        }
+        *p++ = '\n';
+        return p;
+    };
     const char* buy_str = "Buy";
     const char* sell_str = "Sell";
     const char* newlimit_str = "NewLimit";
     const char* newmarket_str = "NewMarket";
     const char* cancel_str = "Cancel";
     
+    // Appends "<n>," (fields of the amend lines)
+    auto put_field = [](char* p, int64_t n) -> char* {
+        char buf[32];
+        char* num_end = buf + sizeof(buf);
+        char* num_start = fast_itoa_signed(n, num_end);
+        std::memcpy(p, num_start, num_end - num_start);
+        p += num_end - num_start;
+        *p++ = ',';
+        return p;
+    };
+    
     int64_t current_ts = start_ts;
     int64_t messages_generated = 0;
     
@@ -132,7 +186,39 @@ int main(int argc, char* argv[]) {
             const char* side_str = side_val ? sell_str : buy_str;
             size_t side_len = side_val ? 4 : 3;
             
-            if (msg_type == 2 && num_active_orders > 0) {
+            // Symbol (drawn only for multi-symbol runs, so single-symbol
+            // output is unchanged)
+            uint32_t symbol = multi_symbol ? static_cast<uint32_t>(xoshiro_next() % num_symbols) : 0;
+            
+            // Amend (drawn only when enabled, so the classic mix is unchanged)
+            if (modify_pct > 0 && num_active_orders > 0 && xoshiro_next() % 100 < modify_pct) {
+                // Probe from a random slot to the next live order (the
+                // table is mostly full, so this is a few steps)
+                size_t i = xoshiro_next() % MAX_ORDERS;
+                while (!orders[i].valid) i = (i + 1) % MAX_ORDERS;
+                bool replace = xoshiro_next() % 4 == 0;
+                orders[i].price += static_cast<int64_t>(xoshiro_next() % 5) - 2;
+                int64_t qty = 1 + static_cast<int64_t>(xoshiro_next() % 1000);
+                
+                // Format: timestamp,Modify|CancelReplace,side,order_id,price,qty\n
+                char* p = buffer + buffer_pos;
+                p = put_field(p, current_ts);
+                const char* type_str = replace ? "CancelReplace" : "Modify";
+                size_t type_len = replace ? 13 : 6;
+                std::memcpy(p, type_str, type_len);
+                p += type_len;
+                *p++ = ',';
+                std::memcpy(p, orders[i].side ? sell_str : buy_str, orders[i].side ? 4 : 3);
+                p += orders[i].side ? 4 : 3;
+                *p++ = ',';
+                p = put_field(p, static_cast<int64_t>(orders[i].id));
+                p = put_field(p, orders[i].price);
+                p = put_field(p, qty);
+                p = end_line(p - 1, orders[i].symbol);  // drop the last ','
+                
+                buffer_pos = p - buffer;
+                messages_generated++;
+            } else if (msg_type == 2 && num_active_orders > 0) {
                 // Cancel
                 uint64_t cancel_idx = rnd_batch[rnd_idx++] % num_active_orders;
                 size_t found = 0;
@@ -141,6 +227,7 @@ int main(int argc, char* argv[]) {
                         if (found == cancel_idx) {
                             uint64_t order_id = orders[i].id;
                             int8_t cancel_side = orders[i].side;
+                            uint32_t cancel_symbol = orders[i].symbol;
                             orders[i].valid = false;
                             num_active_orders--;
                             
@@ -179,7 +266,7 @@ int main(int argc, char* argv[]) {
                             *p++ = '0';
                             *p++ = ',';
                             *p++ = '0';
-                            *p++ = '\n';
+                            p = end_line(p, cancel_symbol);
                             
                             buffer_pos = p - buffer;
                             messages_generated++;
@@ -232,7 +319,7 @@ int main(int argc, char* argv[]) {
                 size_t qty_len = qty_end - qty_start;
                 std::memcpy(p, qty_start, qty_len);
                 p += qty_len;
-                *p++ = '\n';
+                p = end_line(p, symbol);
                 
                 buffer_pos = p - buffer;
                 messages_generated++;
@@ -249,6 +336,7 @@ int main(int argc, char* argv[]) {
                             orders[i].id = order_id;
                             orders[i].side = side_val;
                             orders[i].price = price;
+                            orders[i].symbol = symbol;
                             orders[i].valid = true;
                             num_active_orders++;
                             break;
@@ -270,6 +358,7 @@ int main(int argc, char* argv[]) {
                             orders[i].id = order_id;
                             orders[i].side = side_val;
                             orders[i].price = price;
+                            orders[i].symbol = symbol;
                             orders[i].valid = true;
                             num_active_orders++;
                             break;
@@ -320,7 +409,7 @@ int main(int argc, char* argv[]) {
                 size_t qty_len = qty_end - qty_start;
                 std::memcpy(p, qty_start, qty_len);
                 p += qty_len;
-                *p++ = '\n';
+                p = end_line(p, symbol);
                 
                 buffer_pos = p - buffer;
                 messages_generated++;
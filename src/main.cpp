@@ -1,21 +1,47 @@
 #include "OrderBook.h"
 #include "CSVReader.h"
+#include "BinaryFormat.h"
+#include "SPSCQueue.h"
+#include "MatchingEngine.h"
+#include "LatencyHistogram.h"
+#include "PerfCounters.h"
+#include "Journal.h"
 #include <iostream>
 #include <chrono>
 #include <iomanip>
 #include <vector>
 #include <algorithm>
-#include <numeric>
 #include <fstream>
 #include <sstream>
 #include <cstring>
+#include <memory>
+#include <span>
+#include <thread>
 
 #ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
 #include <windows.h>
 #else
 #include <unistd.h>
 #include <sys/utsname.h>
+#include <sys/resource.h>
+#endif
+
+// Peak resident set size in MB (0 if unavailable)
+double get_peak_rss_mb() {
+#ifdef _WIN32
+    return 0.0;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0.0;
+    return usage.ru_maxrss / 1024.0;  // ru_maxrss is in KB on Linux
 #endif
+}
 
 // Get system info for benchmarking
 std::string get_cpu_info() {
@@ -65,6 +91,99 @@ std::string get_compiler_info() {
 #endif
 }
 
+// What a message did to the book, derived after the fact from the trades it
+// appended, whether it found the id it names resting (cancel, amend) and
+// whether that id rests after it ran (IOC/FOK/PostOnly limit)
+enum class MsgOutcome : uint8_t {
+    Rested,       // limit order rested without trading
+    PartialFill,  // traded, then rested (limit), dropped its residual (IOC) or
+                  // ran out of liquidity (market)
+    Filled,       // fully filled on arrival
+    NoLiquidity,  // market order met an empty side
+    CancelHit,    // cancel removed a resting order
+    CancelMiss,   // cancel id was not resting (filled, cancelled or unknown)
+    Amended,      // modify/cancel-replace changed a resting order without trading
+    AmendMiss,    // modify/cancel-replace id was not resting
+    Killed        // IOC/FOK/PostOnly limit left without trading or resting
+};
+static constexpr size_t MSG_OUTCOME_COUNT = 9;
+
+// replay's book handler: the trade vector, plus a count of the resting
+// orders that cancels and amends found (each hit raises exactly one
+// cancelled or modified event, a miss none). Hits and misses are read from
+// it after the timed call, so nothing probes the id index ahead of
+// process_message and warms what the message is about to touch.
+class ReplayHandler : public TradeCollector {
+private:
+    uint64_t targets_found_ = 0;
+
+public:
+    ALWAYS_INLINE void on_order_cancelled(const Order&) noexcept { targets_found_++; }
+    ALWAYS_INLINE void on_order_modified(OrderId, Side, Price, Quantity, Price, Quantity) noexcept {
+        targets_found_++;
+    }
+
+    uint64_t targets_found() const noexcept { return targets_found_; }
+};
+
+// new_trades: trades the message appended (empty if the book does not
+// record trades, in which case an order that traded counts as Filled).
+// target_resting: the id a cancel or amend names was resting beforehand.
+// killed: a non-GTC limit order is not resting afterwards.
+MsgOutcome classify_message(const Msg& msg, std::span<const Trade> new_trades, uint64_t fills,
+                            bool target_resting, bool killed, uint32_t& levels_swept) {
+    levels_swept = 0;
+    if (msg.type == MsgType::Cancel) {
+        return target_resting ? MsgOutcome::CancelHit : MsgOutcome::CancelMiss;
+    }
+    if (targets_resting_order(msg.type) && !target_resting) {
+        return MsgOutcome::AmendMiss;
+    }
+    if (fills == 0) {
+        if (killed) return MsgOutcome::Killed;
+        return msg.type == MsgType::NewLimit ? MsgOutcome::Rested
+             : msg.type == MsgType::NewMarket ? MsgOutcome::NoLiquidity : MsgOutcome::Amended;
+    }
+    
+    // Fills arrive level by level, so a price change is a new level
+    Quantity filled = 0;
+    for (size_t k = 0; k < new_trades.size(); ++k) {
+        filled += new_trades[k].qty;
+        if (k == 0 || new_trades[k].price != new_trades[k - 1].price) levels_swept++;
+    }
+    return (!new_trades.empty() && filled < msg.qty) ? MsgOutcome::PartialFill : MsgOutcome::Filled;
+}
+
+// Per-message latency in TSC ticks: overall, and broken out by message type,
+// by outcome and (for orders that traded) by price levels swept
+struct LatencyBreakdown {
+    static constexpr size_t SWEEP_BUCKETS = 4;   // 1, 2, 3-4, 5+ levels
+    
+    LatencyHistogram all;
+    LatencyHistogram by_type[MSG_TYPES];
+    LatencyHistogram by_outcome[MSG_OUTCOME_COUNT];
+    LatencyHistogram by_levels[SWEEP_BUCKETS];
+    
+    static size_t sweep_bucket(uint32_t levels) noexcept {
+        return levels <= 2 ? levels - 1 : (levels <= 4 ? 2 : 3);
+    }
+    
+    void record(MsgType type, MsgOutcome outcome, uint32_t levels_swept, uint64_t ticks) noexcept {
+        all.record(ticks);
+        // Readers reject unknown types; still never index past the array
+        if (size_t t = static_cast<size_t>(type); t < MSG_TYPES) by_type[t].record(ticks);
+        by_outcome[static_cast<size_t>(outcome)].record(ticks);
+        if (levels_swept > 0) by_levels[sweep_bucket(levels_swept)].record(ticks);
+    }
+};
+
+static const char* const MSG_TYPE_NAMES[MSG_TYPES] = {
+    "new_limit", "new_market", "cancel", "modify", "cancel_replace"};
+static const char* const OUTCOME_NAMES[MSG_OUTCOME_COUNT] = {
+    "rested", "partial_fill", "filled", "no_liquidity", "cancel_hit", "cancel_miss", "amended", "amend_miss",
+    "killed"};
+static const char* const SWEEP_NAMES[LatencyBreakdown::SWEEP_BUCKETS] = {"1", "2", "3-4", "5+"};
+
 struct Metrics {
     uint64_t events;
     double engine_time_ms;
@@ -82,8 +201,64 @@ struct Metrics {
     std::string compiler;
     std::string commit;
     double csv_read_ms;
+    PoolStats order_pool;
+    LevelStats levels;
+    struct {
+        bool enabled;
+        size_t ring_capacity;
+        uint64_t parse_stalls;   // parser found the ring full (engine-bound)
+        uint64_t engine_stalls;  // engine found the ring empty (parser-bound)
+        double peak_rss_mb;
+    } stream;
+    size_t workers;   // engine threads (0 = single book on the main thread)
+    size_t symbols;
+    const LatencyBreakdown* latency;  // nullptr when not tracked
+    double tsc_ticks_per_ns;
+    struct {
+        bool requested;
+        bool available;
+        std::string error;           // first event that failed to open
+        PerfSample total;            // whole engine loop
+        bool by_type;
+        PerfSample type_totals[MSG_TYPES];
+        uint64_t type_counts[MSG_TYPES];
+    } perf;
 };
 
+// "cycles": x, "instructions": y, ... per message (opened events only)
+void write_perf_json(std::ofstream& file, const PerfSample& s, uint64_t messages) {
+    bool first = true;
+    for (size_t i = 0; i < PERF_EVENT_COUNT; ++i) {
+        if (!s.valid[i]) continue;
+        file << (first ? "" : ", ") << "\"" << perf_event_name(static_cast<PerfEvent>(i)) << "\": "
+             << (messages ? static_cast<double>(s.values[i]) / messages : 0.0);
+        first = false;
+    }
+}
+
+// {"count": n, "p50": .., "p99": .., "p99.9": .., "max": .., "mean": ..} in ns
+void write_histogram_json(std::ofstream& file, const LatencyHistogram& h, double ticks_per_ns) {
+    auto ns = [ticks_per_ns](double ticks) { return ticks / ticks_per_ns; };
+    file << "{\"count\": " << h.count()
+         << ", \"p50\": " << ns(h.percentile(50)) << ", \"p99\": " << ns(h.percentile(99))
+         << ", \"p99.9\": " << ns(h.percentile(99.9)) << ", \"max\": " << ns(h.max())
+         << ", \"mean\": " << ns(h.mean()) << "}";
+}
+
+// "name": {"key": {...}, ...} for the non-empty histograms of a group
+void write_histogram_group(std::ofstream& file, const char* name, const LatencyHistogram* hs,
+                           const char* const* keys, size_t n, double ticks_per_ns, bool last) {
+    file << "    \"" << name << "\": {";
+    bool first = true;
+    for (size_t i = 0; i < n; ++i) {
+        if (hs[i].count() == 0) continue;
+        file << (first ? "\n" : ",\n") << "      \"" << keys[i] << "\": ";
+        write_histogram_json(file, hs[i], ticks_per_ns);
+        first = false;
+    }
+    file << (first ? "}" : "\n    }") << (last ? "\n" : ",\n");
+}
+
 void write_metrics_json(const Metrics& metrics, const std::string& filename) {
     std::ofstream file(filename);
     if (!file.is_open()) {
@@ -106,18 +281,218 @@ void write_metrics_json(const Metrics& metrics, const std::string& filename) {
     file << "    \"max\": " << metrics.latency_us.max_us << ",\n";
     file << "    \"avg\": " << metrics.latency_us.avg_us << "\n";
     file << "  },\n";
+    if (metrics.latency) {
+        const LatencyBreakdown& lat = *metrics.latency;
+        file << "  \"latency_ns\": {\n";
+        file << "    \"clock\": \"tsc\",\n";
+        file << "    \"tsc_ticks_per_ns\": " << std::setprecision(4) << metrics.tsc_ticks_per_ns
+             << std::setprecision(2) << ",\n";
+        file << "    \"all\": ";
+        write_histogram_json(file, lat.all, metrics.tsc_ticks_per_ns);
+        file << ",\n";
+        write_histogram_group(file, "by_type", lat.by_type, MSG_TYPE_NAMES,
+                              MSG_TYPES, metrics.tsc_ticks_per_ns, false);
+        write_histogram_group(file, "by_outcome", lat.by_outcome, OUTCOME_NAMES,
+                              MSG_OUTCOME_COUNT, metrics.tsc_ticks_per_ns, false);
+        write_histogram_group(file, "by_levels_swept", lat.by_levels, SWEEP_NAMES,
+                              LatencyBreakdown::SWEEP_BUCKETS, metrics.tsc_ticks_per_ns, true);
+        file << "  },\n";
+    }
+    file << "  \"order_pool\": {\n";
+    file << "    \"in_use\": " << metrics.order_pool.in_use << ",\n";
+    file << "    \"high_water_mark\": " << metrics.order_pool.high_water_mark << ",\n";
+    file << "    \"capacity\": " << metrics.order_pool.capacity << ",\n";
+    file << "    \"chunks\": " << metrics.order_pool.chunks << "\n";
+    file << "  },\n";
+    file << "  \"levels\": {\n";
+    file << "    \"created\": " << metrics.levels.created << ",\n";
+    file << "    \"destroyed\": " << metrics.levels.destroyed << ",\n";
+    file << "    \"cache_hits\": " << metrics.levels.cache_hits << ",\n";
+    file << "    \"cached\": " << metrics.levels.cached << "\n";
+    file << "  },\n";
+    if (metrics.perf.requested) {
+        file << "  \"perf_counters\": {\n";
+        file << "    \"available\": " << (metrics.perf.available ? "true" : "false") << ",\n";
+        if (!metrics.perf.error.empty()) {
+            file << "    \"error\": \"" << metrics.perf.error << "\",\n";
+        }
+        if (metrics.perf.available) {
+            const PerfSample& total = metrics.perf.total;
+            file << "    \"multiplexed\": " << (total.multiplexed ? "true" : "false") << ",\n";
+            if (total.valid[0] && total.valid[1] && total[PerfEvent::Cycles] > 0) {
+                file << "    \"ipc\": " << static_cast<double>(total[PerfEvent::Instructions]) /
+                                            total[PerfEvent::Cycles] << ",\n";
+            }
+            if (metrics.perf.by_type) {
+                file << "    \"by_type\": {";
+                bool first = true;
+                for (size_t t = 0; t < MSG_TYPES; ++t) {
+                    if (metrics.perf.type_counts[t] == 0) continue;
+                    file << (first ? "\n" : ",\n") << "      \"" << MSG_TYPE_NAMES[t] << "\": {\"count\": "
+                         << metrics.perf.type_counts[t] << ", ";
+                    write_perf_json(file, metrics.perf.type_totals[t], metrics.perf.type_counts[t]);
+                    file << "}";
+                    first = false;
+                }
+                file << (first ? "}" : "\n    }") << ",\n";
+            }
+        }
+        file << "    \"per_msg\": {";
+        write_perf_json(file, metrics.perf.total, metrics.events);
+        file << "}\n";
+        file << "  },\n";
+    }
+    if (metrics.stream.enabled) {
+        file << "  \"stream\": {\n";
+        file << "    \"ring_capacity\": " << metrics.stream.ring_capacity << ",\n";
+        file << "    \"parse_stalls\": " << metrics.stream.parse_stalls << ",\n";
+        file << "    \"engine_stalls\": " << metrics.stream.engine_stalls << ",\n";
+        file << "    \"peak_rss_mb\": " << metrics.stream.peak_rss_mb << "\n";
+        file << "  },\n";
+    }
     file << "  \"cpu\": \"" << metrics.cpu << "\",\n";
     file << "  \"compiler\": \"" << metrics.compiler << "\",\n";
     file << "  \"commit\": \"" << metrics.commit << "\",\n";
-    file << "  \"single_threaded\": true\n";
+    if (metrics.workers > 0) {
+        file << "  \"workers\": " << metrics.workers << ",\n";
+        file << "  \"symbols\": " << metrics.symbols << ",\n";
+    }
+    file << "  \"single_threaded\": " << (metrics.stream.enabled || metrics.workers > 0 ? "false" : "true") << "\n";
     file << "}\n";
     file.close();
 }
 
+// Write metrics JSON, creating the results directory if needed
+void save_metrics(const Metrics& metrics, const std::string& metrics_file) {
+    size_t last_slash = metrics_file.find_last_of("/\\");
+    if (last_slash != std::string::npos) {
+        std::string dir = metrics_file.substr(0, last_slash);
+        #ifdef _WIN32
+        system(("mkdir \"" + dir + "\" 2>nul").c_str());
+        #else
+        system(("mkdir -p \"" + dir + "\" 2>/dev/null").c_str());
+        #endif
+    }
+    write_metrics_json(metrics, metrics_file);
+    std::cout << "\nMetrics written to: " << metrics_file << std::endl;
+}
+
+// Multi-symbol replay: the main thread dispatches, books live on workers.
+// Per-message latency is not sampled (messages complete on other threads).
+int run_sharded(size_t threads, const std::vector<Msg>& messages, const BinaryMessageFile* binary,
+                size_t num_messages, double csv_read_ms, const std::string& metrics_file) {
+    MatchingEngine engine(threads);
+    
+    auto engine_start = std::chrono::steady_clock::now();
+    if (binary) {
+        // Decoded a run at a time and submitted as one
+        std::vector<Msg> run(MatchingEngine::SUBMIT_BATCH);
+        for (size_t i = 0; i < num_messages; i += run.size()) {
+            size_t n = std::min(run.size(), num_messages - i);
+            for (size_t k = 0; k < n; ++k) to_msg((*binary)[i + k], run[k]);
+            engine.submit(run.data(), n);
+        }
+    } else {
+        engine.submit(messages.data(), messages.size());
+    }
+    engine.stop();
+    auto engine_end = std::chrono::steady_clock::now();
+    double engine_time_ms = std::chrono::duration_cast<std::chrono::microseconds>(
+        engine_end - engine_start).count() / 1000.0;
+    double throughput_mps = num_messages / (engine_time_ms / 1000.0);
+    
+    uint64_t total_messages = 0;
+    uint64_t total_trades = 0;
+    PoolStats pool{};
+    LevelStats levels{};
+    engine.for_each_book([&](uint32_t, const ShardBook& book) {
+        levels += book.level_stats();
+        total_messages += book.get_total_messages();
+        total_trades += book.get_total_trades();
+    });
+    // One pool per worker, shared by its books
+    for (size_t w = 0; w < engine.worker_count(); ++w) {
+        PoolStats stats = engine.worker_stats(w).orders;
+        pool.in_use += stats.in_use;
+        pool.high_water_mark += stats.high_water_mark;
+        pool.capacity += stats.capacity;
+        pool.chunks += stats.chunks;
+    }
+    
+    std::cout << "\n=== Summary ===" << std::endl;
+    std::cout << "Total messages: " << total_messages << std::endl;
+    std::cout << "Total trades: " << total_trades << std::endl;
+    std::cout << "Symbols: " << engine.symbol_count() << " across " << engine.worker_count() << " workers" << std::endl;
+    if (engine.rejected() > 0) {
+        std::cout << "Rejected (symbol id >= " << MatchingEngine::MAX_SYMBOLS << "): " << engine.rejected() << std::endl;
+    }
+    
+    const uint32_t MAX_LISTED = 16;
+    engine.for_each_book([&](uint32_t symbol, const ShardBook& book) {
+        if (symbol >= MAX_LISTED) return;
+        std::cout << "  [" << symbol << "] trades " << book.get_total_trades()
+                  << ", bid " << book.best_bid() << " x " << book.best_bid_qty()
+                  << ", ask " << book.best_ask() << " x " << book.best_ask_qty() << std::endl;
+    });
+    
+    std::cout << "Order pools: " << pool.in_use << " in use, high-water " << pool.high_water_mark
+              << ", capacity " << pool.capacity << " (" << pool.chunks << " chunks)" << std::endl;
+    std::cout << "Price levels: " << levels.created << " created, " << levels.destroyed << " destroyed, "
+              << levels.cache_hits << " from cache" << std::endl;
+    
+    std::cout << "\n=== Workers ===" << std::endl;
+    for (size_t w = 0; w < engine.worker_count(); ++w) {
+        WorkerStats stats = engine.worker_stats(w);
+        std::cout << "Worker " << w << ": " << stats.messages << " messages, " << stats.books << " books, "
+                  << stats.idle_spins << " idle spins, " << stats.submit_stalls << " submit stalls" << std::endl;
+    }
+    
+    std::cout << "\n=== Performance (Engine-Only) ===" << std::endl;
+    std::cout << "CSV Read time: " << std::fixed << std::setprecision(2) << csv_read_ms << " ms" << std::endl;
+    std::cout << "Engine time: " << engine_time_ms << " ms" << std::endl;
+    std::cout << "Throughput: " << std::setprecision(2) << throughput_mps << " messages/second" << std::endl;
+    
+    Metrics metrics{};
+    metrics.events = num_messages;
+    metrics.engine_time_ms = engine_time_ms;
+    metrics.throughput_mps = throughput_mps;
+    metrics.csv_read_ms = csv_read_ms;
+    metrics.cpu = get_cpu_info();
+    metrics.compiler = get_compiler_info();
+    metrics.commit = "unknown";
+    metrics.order_pool = pool;
+    metrics.levels = levels;
+    metrics.workers = engine.worker_count();
+    metrics.symbols = engine.symbol_count();
+    
+    std::cout << "\n=== System Info ===" << std::endl;
+    std::cout << "CPU: " << metrics.cpu << std::endl;
+    std::cout << "Compiler: " << metrics.compiler << std::endl;
+    std::cout << "Single-threaded: No (dispatcher + " << engine.worker_count() << " workers)" << std::endl;
+    
+    if (!metrics_file.empty()) {
+        save_metrics(metrics, metrics_file);
+    }
+    return 0;
+}
+
 int main(int argc, char* argv[]) {
     std::string csv_file;
     std::string metrics_file;
-    bool sample_latency = true;  // Sample 1/1000 messages for latency tracking
+    bool sample_latency = true;  // Time every message into latency histograms
+    bool legacy_csv = false;     // Use the istringstream reader instead of mmap
+    bool binary_input = false;   // Input is a csv2bin file, replayed in place
+    bool stream = false;         // Parser thread feeds the engine over an SPSC ring
+    size_t ring_size = 64 * 1024;
+    size_t threads = 0;          // >0: multi-symbol MatchingEngine with N workers
+    bool perf_counters = false;  // Hardware counters around the engine loop
+    bool perf_by_type = false;   // ... and per message type (2 reads per message)
+    std::string load_snapshot;   // Restore the book, replay only the input tail
+    std::string save_snapshot;   // Checkpoint the book after the replay
+    size_t stop_after = 0;       // >0: stop at this input position (mid-session snapshots)
+    std::string recover_file;    // Replay a journal into the book before the input
+    std::string journal_file;    // Journal every applied message (group commit)
+    JournalOptions journal_options;
     
     // Parse arguments
     for (int i = 1; i < argc; ++i) {
@@ -125,79 +500,365 @@ int main(int argc, char* argv[]) {
             metrics_file = argv[++i];
         } else if (strcmp(argv[i], "--no-latency") == 0) {
             sample_latency = false;
+        } else if (strcmp(argv[i], "--legacy-csv") == 0) {
+            legacy_csv = true;
+        } else if (strcmp(argv[i], "--binary") == 0) {
+            binary_input = true;
+        } else if (strcmp(argv[i], "--stream") == 0) {
+            stream = true;
+        } else if (strcmp(argv[i], "--ring-size") == 0 && i + 1 < argc) {
+            ring_size = std::strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = std::strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--perf-counters") == 0) {
+            perf_counters = true;
+        } else if (strcmp(argv[i], "--perf-by-type") == 0) {
+            perf_counters = perf_by_type = true;
+        } else if (strcmp(argv[i], "--load-snapshot") == 0 && i + 1 < argc) {
+            load_snapshot = argv[++i];
+        } else if (strcmp(argv[i], "--save-snapshot") == 0 && i + 1 < argc) {
+            save_snapshot = argv[++i];
+        } else if (strcmp(argv[i], "--stop-after") == 0 && i + 1 < argc) {
+            stop_after = std::strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--recover") == 0 && i + 1 < argc) {
+            recover_file = argv[++i];
+        } else if (strcmp(argv[i], "--journal") == 0 && i + 1 < argc) {
+            journal_file = argv[++i];
+        } else if (strcmp(argv[i], "--group-commit-us") == 0 && i + 1 < argc) {
+            journal_options.group_commit_us = std::strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--journal-batch") == 0 && i + 1 < argc) {
+            journal_options.max_batch = std::strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--journal-no-sync") == 0) {
+            journal_options.sync = false;
         } else if (csv_file.empty()) {
             csv_file = argv[i];
         }
     }
     
     if (csv_file.empty()) {
-        std::cerr << "Usage: " << argv[0] << " <csv_file> [--metrics <json_file>] [--no-latency]" << std::endl;
+        std::cerr << "Usage: " << argv[0] << " <csv_file> [--metrics <json_file>] [--no-latency] [--legacy-csv] [--binary]"
+                  << " [--stream [--ring-size <msgs>]] [--threads <workers>]"
+                  << " [--perf-counters] [--perf-by-type]"
+                  << " [--load-snapshot <file>] [--save-snapshot <file>] [--stop-after <msgs>]"
+                  << " [--recover <journal>] [--journal <file> [--group-commit-us <us>] [--journal-batch <msgs>]"
+                  << " [--journal-no-sync]]" << std::endl;
+        return 1;
+    }
+    
+    if (stream && binary_input) {
+        std::cerr << "--stream reads CSV; binary files are already replayed in place" << std::endl;
+        return 1;
+    }
+    
+    if (stream && threads > 0) {
+        std::cerr << "--threads replays a loaded or mapped input; drop --stream" << std::endl;
+        return 1;
+    }
+    
+    if (perf_counters && threads > 0) {
+        std::cerr << "--perf-counters measures the single-book engine loop; drop --threads" << std::endl;
+        return 1;
+    }
+    
+    if ((!load_snapshot.empty() || !save_snapshot.empty() || stop_after > 0 ||
+         !recover_file.empty() || !journal_file.empty()) && threads > 0) {
+        std::cerr << "Snapshots and journals cover a single book; drop --threads" << std::endl;
         return 1;
     }
     
-    // Read messages from CSV
-    std::cout << "Reading messages from " << csv_file << "..." << std::endl;
+    if (!journal_file.empty() && journal_file == recover_file) {
+        std::cerr << "--journal would truncate the journal being recovered; write a new file" << std::endl;
+        return 1;
+    }
+    
+    // Read messages from CSV (or map the binary file: records are decoded
+    // one at a time inside the engine loop, no std::vector<Msg>). Streaming
+    // mode reads nothing up front: parsing overlaps the engine loop.
     auto csv_start = std::chrono::steady_clock::now();
-    auto messages = CSVReader::read_messages(csv_file);
+    std::vector<Msg> messages;
+    std::unique_ptr<BinaryMessageFile> binary;
+    std::unique_ptr<CSVStreamReader> stream_reader;
+    size_t num_messages = 0;
+    if (stream) {
+        std::cout << "Streaming messages from " << csv_file << " (ring of " << ring_size << ")..." << std::endl;
+        stream_reader = std::make_unique<CSVStreamReader>(csv_file);
+        if (!stream_reader->is_open()) {
+            return 1;
+        }
+    } else if (binary_input) {
+        std::cout << "Reading messages from " << csv_file << "..." << std::endl;
+        binary = std::make_unique<BinaryMessageFile>(csv_file);
+        if (!binary->is_valid()) {
+            std::cerr << "Error: " << binary->error() << std::endl;
+            return 1;
+        }
+        num_messages = binary->size();
+    } else {
+        std::cout << "Reading messages from " << csv_file << "..." << std::endl;
+        messages = legacy_csv ? CSVReader::read_messages(csv_file)
+                              : CSVReader::read_messages_mmap(csv_file);
+        num_messages = messages.size();
+    }
     auto csv_end = std::chrono::steady_clock::now();
     auto csv_elapsed = std::chrono::duration_cast<std::chrono::microseconds>(csv_end - csv_start);
-    double csv_read_ms = csv_elapsed.count() / 1000.0;
+    double csv_read_ms = stream ? 0.0 : csv_elapsed.count() / 1000.0;
     
-    if (messages.empty()) {
-        std::cerr << "No messages loaded. Exiting." << std::endl;
-        return 1;
+    if (!stream) {
+        if (num_messages == 0) {
+            std::cerr << "No messages loaded. Exiting." << std::endl;
+            return 1;
+        }
+        
+        std::cout << (binary_input ? "Mapped " : "Loaded ") << num_messages << " messages in " << csv_elapsed.count() 
+                  << " microseconds (" << std::fixed << std::setprecision(2) << csv_read_ms << " ms)." << std::endl;
+    }
+    
+    if (threads > 0) {
+        return run_sharded(threads, messages, binary.get(), num_messages, csv_read_ms, metrics_file);
     }
     
-    std::cout << "Loaded " << messages.size() << " messages in " << csv_elapsed.count() 
-              << " microseconds (" << std::fixed << std::setprecision(2) << csv_read_ms << " ms)." << std::endl;
+    // Create order book (trade buffer sized once, off the timed path)
+    BasicOrderBook<ReplayHandler> book;
+    book.reserve_trades(num_messages);
     
-    // Create order book
-    OrderBook book;
+    // Restart from a checkpoint: the book resumes at input position
+    // get_total_messages(), so only the tail of the input is replayed
+    size_t first = 0;
+    if (!load_snapshot.empty()) {
+        auto load_start = std::chrono::steady_clock::now();
+        if (!book.load_snapshot(load_snapshot)) {
+            return 1;
+        }
+        auto load_end = std::chrono::steady_clock::now();
+        first = book.get_total_messages();
+        if (!stream && first > num_messages) {
+            std::cerr << "Snapshot is at message " << first << " but the input has only "
+                      << num_messages << std::endl;
+            return 1;
+        }
+        std::cout << "Restored " << book.pool_stats().in_use << " orders at message " << first << " in "
+                  << std::fixed << std::setprecision(2)
+                  << std::chrono::duration<double, std::milli>(load_end - load_start).count()
+                  << " ms" << std::endl;
+    }
     
-    // Latency tracking: sample every Nth message for large datasets
-    const size_t LATENCY_SAMPLE_RATE = 1000;  // Sample 1 in 1000 messages
-    std::vector<uint64_t> latencies;
-    bool track_latency = sample_latency;
+    // Crash recovery: apply the journaled messages on top (of the snapshot,
+    // if any), then continue with the input after the last one
+    if (!recover_file.empty()) {
+        auto recover_start = std::chrono::steady_clock::now();
+        JournalRecovery recovered = recover_journal(recover_file, book);
+        if (!recovered.ok) {
+            std::cerr << "Error: " << recover_file << ": " << recovered.error << std::endl;
+            return 1;
+        }
+        auto recover_end = std::chrono::steady_clock::now();
+        first = book.get_total_messages();
+        if (!stream && first > num_messages) {
+            std::cerr << "Journal reaches message " << first << " but the input has only "
+                      << num_messages << std::endl;
+            return 1;
+        }
+        std::cout << "Recovered " << recovered.applied << " journaled messages (" << recovered.frames << " frames";
+        if (recovered.skipped > 0) std::cout << ", " << recovered.skipped << " already in the snapshot";
+        if (recovered.torn_tail) std::cout << ", torn tail ignored";
+        std::cout << ") in " << std::fixed
+                  << std::setprecision(2) << std::chrono::duration<double, std::milli>(recover_end - recover_start).count()
+                  << " ms; resuming at message " << first << std::endl;
+    }
+    
+    std::unique_ptr<Journal> journal;
+    if (!journal_file.empty()) {
+        journal = std::make_unique<Journal>(journal_file, book.get_total_messages(), journal_options);
+        if (!journal->is_open()) {
+            std::cerr << "Error: " << journal->error() << std::endl;
+            return 1;
+        }
+    }
+    size_t last = (stop_after > 0) ? std::max(stop_after, first) : SIZE_MAX;
+    size_t applied = 0;
     
+    // Latency tracking: every message timed with TSC reads into fixed-size
+    // histograms (no sampling, no per-message storage)
+    bool track_latency = sample_latency;
+    std::unique_ptr<LatencyBreakdown> latency;
+    double ticks_per_ns = 1.0;
     if (track_latency) {
-        size_t expected_samples = (messages.size() < 1'000'000) 
-            ? messages.size() 
-            : messages.size() / LATENCY_SAMPLE_RATE + 1;
-        latencies.reserve(expected_samples);
+        latency = std::make_unique<LatencyBreakdown>();
+        ticks_per_ns = tsc_ticks_per_ns();  // calibrate before the timed loop
+    }
+    
+    // Hardware counters: this thread only (the stream parser is not counted)
+    std::unique_ptr<PerfCounters> perf;
+    PerfSample perf_type_totals[MSG_TYPES];
+    uint64_t perf_type_counts[MSG_TYPES] = {};
+    if (perf_counters) {
+        perf = std::make_unique<PerfCounters>();
+        if (!perf->available()) {
+            std::cerr << "Warning: perf counters unavailable (" << perf->error() << ")" << std::endl;
+            perf_by_type = false;
+        } else if (!perf->error().empty()) {
+            std::cerr << "Warning: some perf counters unavailable (" << perf->error() << ")" << std::endl;
+        }
     }
     
     // ENGINE-ONLY TIMING: Time only the matching loop (separate from CSV I/O)
+    if (perf) perf->start();
     auto engine_start = std::chrono::steady_clock::now();
     
-    for (size_t i = 0; i < messages.size(); ++i) {
-        const auto& msg = messages[i];
-        
-        // Sample latency for every message (small datasets) or every Nth (large datasets)
-        bool should_sample = track_latency && (
-            messages.size() <= 1'000'000 || (i % LATENCY_SAMPLE_RATE == 0)
-        );
+    auto run_message = [&](const Msg& msg) {
+        if (journal) journal->append(msg);
+        if (!track_latency && !perf_by_type) {
+            book.process_message(msg);
+            return;
+        }
+        size_t trades_before = book.get_trades().size();
+        uint64_t fills_before = book.get_total_trades();
+        uint64_t found_before = book.handler().targets_found();
+        PerfSample perf_before;
+        if (perf_by_type) perf_before = perf->read();
         
-        auto msg_start = should_sample ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
+        uint64_t msg_start = clock_now<ClockSource::Tsc>();
         book.process_message(msg);
-        auto msg_end = should_sample ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
+        uint64_t msg_end = clock_now<ClockSource::Tsc>();
+        
+        if (size_t t = static_cast<size_t>(msg.type); perf_by_type && t < MSG_TYPES) {
+            perf_type_totals[t] += perf->read().since(perf_before);
+            perf_type_counts[t]++;
+        }
+        if (!track_latency) return;
+        
+        const auto& trades = book.get_trades();
+        bool target_resting = book.handler().targets_found() != found_before;
+        bool killed = msg.type == MsgType::NewLimit && msg.tif != TimeInForce::GTC &&
+                      book.find_order(msg.id) == nullptr;
+        uint32_t levels_swept;
+        MsgOutcome outcome = classify_message(
+            msg, std::span<const Trade>(trades.data() + trades_before, trades.size() - trades_before),
+            book.get_total_trades() - fills_before, target_resting, killed, levels_swept);
+        latency->record(msg.type, outcome, levels_swept, msg_end - msg_start);
+    };
+    
+    uint64_t parse_stalls = 0;
+    uint64_t engine_stalls = 0;
+    size_t ring_capacity = 0;
+    
+    if (stream) {
+        // Parser thread fills the ring in place; the engine drains it in
+        // batches. A full ring blocks the parser (back-pressure), so memory
+        // is bounded by the ring and read buffer regardless of input size.
+        const size_t STREAM_BATCH = 1024;
+        SPSCQueue<Msg> ring(ring_size);
+        ring_capacity = ring.capacity();
+        
+        std::thread parser([&] {
+            uint64_t stalls = 0;
+            for (;;) {
+                Msg* slots;
+                size_t room = ring.claim(slots, STREAM_BATCH);
+                if (room == 0) {
+                    spsc_backoff(++stalls);
+                    continue;
+                }
+                size_t parsed = stream_reader->next_batch(slots, room);
+                if (parsed == 0) break;
+                ring.publish(parsed);
+            }
+            parse_stalls = stalls;
+            ring.close();
+        });
+        
+        size_t i = 0;
+        for (;;) {
+            const Msg* batch;
+            size_t n = ring.peek(batch, STREAM_BATCH);
+            if (n == 0) {
+                if (ring.drained()) break;
+                spsc_backoff(++engine_stalls);
+                continue;
+            }
+            // Keep draining outside [first, last) so the parser never blocks
+            size_t lo = std::clamp(first, i, i + n) - i;
+            size_t hi = std::clamp(last, i, i + n) - i;
+            for (size_t k = lo; k < hi; ++k) {
+                run_message(batch[k]);
+            }
+            applied += hi - lo;
+            i += n;
+            ring.release(n);
+        }
         
-        if (should_sample) {
-            auto msg_latency = std::chrono::duration_cast<std::chrono::nanoseconds>(
-                msg_end - msg_start).count();
-            latencies.push_back(msg_latency);
+        parser.join();
+        num_messages = i;
+        
+        if (stream_reader->malformed() > 0) {
+            std::cerr << "Warning: skipped " << stream_reader->malformed() << " malformed lines" << std::endl;
+        }
+        if (num_messages == 0) {
+            std::cerr << "No messages loaded. Exiting." << std::endl;
+            return 1;
         }
+    } else if (binary) {
+        Msg msg{};
+        last = std::min(last, num_messages);
+        for (size_t i = first; i < last; ++i) {
+            to_msg((*binary)[i], msg);
+            run_message(msg);
+        }
+        applied = last - first;
+    } else {
+        last = std::min(last, num_messages);
+        for (size_t i = first; i < last; ++i) {
+            run_message(messages[i]);
+        }
+        applied = last - first;
     }
     
     auto engine_end = std::chrono::steady_clock::now();
+    if (perf) perf->stop();
     auto engine_elapsed = std::chrono::duration_cast<std::chrono::microseconds>(engine_end - engine_start);
     double engine_time_ms = engine_elapsed.count() / 1000.0;
     
-    // Collect trades
-    auto trades = book.get_trades();
+    if (journal) {
+        auto flush_start = std::chrono::steady_clock::now();
+        bool journal_ok = journal->close();
+        auto flush_end = std::chrono::steady_clock::now();
+        if (!journal_ok) {
+            std::cerr << "Error: journal " << journal_file << ": " << journal->error() << std::endl;
+            return 1;
+        }
+        const LatencyHistogram& sync_ns = journal->sync_latency_ns();
+        std::cout << "Journaled " << journal->records() << " messages in " << journal->frames() << " frames ("
+                  << std::fixed << std::setprecision(1)
+                  << (journal->frames() ? static_cast<double>(journal->records()) / journal->frames() : 0.0)
+                  << " per commit), ";
+        if (sync_ns.count() > 0) {
+            std::cout << sync_ns.count() << " syncs (p50 " << sync_ns.percentile(50) / 1000.0
+                      << " us, p99 " << sync_ns.percentile(99) / 1000.0 << " us), ";
+        }
+        std::cout << journal->append_stalls() << " append stalls, final flush "
+                  << std::setprecision(2) << std::chrono::duration<double, std::milli>(flush_end - flush_start).count()
+                  << " ms" << std::endl;
+    }
     
-    // Calculate ENGINE-ONLY throughput (excluding CSV I/O)
+    if (!save_snapshot.empty()) {
+        auto save_start = std::chrono::steady_clock::now();
+        if (!book.save_snapshot(save_snapshot)) {
+            return 1;
+        }
+        auto save_end = std::chrono::steady_clock::now();
+        std::cout << "Saved " << book.pool_stats().in_use << " orders at message " << book.get_total_messages()
+                  << " to " << save_snapshot << " in " << std::fixed << std::setprecision(2)
+                  << std::chrono::duration<double, std::milli>(save_end - save_start).count()
+                  << " ms" << std::endl;
+    }
+    
+    // Collected trades (no copy)
+    const auto& trades = book.get_trades();
+    
+    // Calculate ENGINE-ONLY throughput (excluding CSV I/O) over the
+    // messages actually applied (the tail only after --load-snapshot)
     double engine_time_seconds = engine_time_ms / 1000.0;
-    double throughput_mps = messages.size() / engine_time_seconds;
+    double throughput_mps = applied / engine_time_seconds;
     
     // Get system info
     std::string cpu_info = get_cpu_info();
@@ -213,39 +874,95 @@ int main(int argc, char* argv[]) {
     std::cout << "Total bid quantity: " << book.total_bid_qty() << std::endl;
     std::cout << "Total ask quantity: " << book.total_ask_qty() << std::endl;
     
+    PoolStats pool = book.pool_stats();
+    std::cout << "Order pool: " << pool.in_use << " in use, high-water " << pool.high_water_mark
+              << ", capacity " << pool.capacity << " (" << pool.chunks << " chunks)" << std::endl;
+    LevelStats levels = book.level_stats();
+    std::cout << "Price levels: " << levels.created << " created, " << levels.destroyed << " destroyed, "
+              << levels.cache_hits << " from cache" << std::endl;
+    
     std::cout << "\n=== Performance (Engine-Only) ===" << std::endl;
     std::cout << "CSV Read time: " << std::fixed << std::setprecision(2) << csv_read_ms << " ms" << std::endl;
     std::cout << "Engine time: " << engine_time_ms << " ms" << std::endl;
     std::cout << "Throughput: " << std::setprecision(2) << throughput_mps << " messages/second" << std::endl;
     
+    double peak_rss_mb = get_peak_rss_mb();
+    if (stream) {
+        // Engine time here includes parsing overlapped on the other thread
+        std::cout << "\n=== Streaming Pipeline ===" << std::endl;
+        std::cout << "Ring capacity: " << ring_capacity << " messages" << std::endl;
+        std::cout << "Parse stalls (ring full, engine-bound): " << parse_stalls << std::endl;
+        std::cout << "Engine stalls (ring empty, parser-bound): " << engine_stalls << std::endl;
+        std::cout << "Peak RSS: " << std::setprecision(1) << peak_rss_mb << " MB" << std::endl;
+    }
+    
     std::cout << "\n=== System Info ===" << std::endl;
     std::cout << "CPU: " << cpu_info << std::endl;
     std::cout << "Compiler: " << compiler_info << std::endl;
-    std::cout << "Single-threaded: Yes" << std::endl;
+    std::cout << "Single-threaded: " << (stream ? "No (parser + engine)" : "Yes") << std::endl;
     
     // Latency statistics
-    Metrics metrics;
-    metrics.events = messages.size();
+    Metrics metrics{};
+    metrics.events = applied;
     metrics.engine_time_ms = engine_time_ms;
     metrics.throughput_mps = throughput_mps;
     metrics.csv_read_ms = csv_read_ms;
     metrics.cpu = cpu_info;
     metrics.compiler = compiler_info;
     metrics.commit = commit_hash;
+    metrics.order_pool = pool;
+    metrics.levels = levels;
+    metrics.stream.enabled = stream;
+    metrics.stream.ring_capacity = ring_capacity;
+    metrics.stream.parse_stalls = parse_stalls;
+    metrics.stream.engine_stalls = engine_stalls;
+    metrics.stream.peak_rss_mb = peak_rss_mb;
+    metrics.workers = 0;
+    metrics.symbols = 1;
     
-    if (track_latency && !latencies.empty()) {
-        std::sort(latencies.begin(), latencies.end());
-        
-        size_t n = latencies.size();
-        metrics.latency_us.p50_us = latencies[n * 50 / 100] / 1000.0;
-        metrics.latency_us.p95_us = latencies[n * 95 / 100] / 1000.0;
-        metrics.latency_us.p99_us = latencies[n * 99 / 100] / 1000.0;
-        metrics.latency_us.p999_us = (n > 1000) ? latencies[n * 999 / 1000] / 1000.0 : latencies.back() / 1000.0;
-        metrics.latency_us.min_us = latencies.front() / 1000.0;
-        metrics.latency_us.max_us = latencies.back() / 1000.0;
+    metrics.latency = latency.get();
+    metrics.tsc_ticks_per_ns = ticks_per_ns;
+    metrics.perf.requested = perf_counters;
+    metrics.perf.available = perf && perf->available();
+    metrics.perf.error = perf ? perf->error() : std::string();
+    metrics.perf.by_type = perf_by_type;
+    if (metrics.perf.available) {
+        metrics.perf.total = perf->read();
+        for (size_t t = 0; t < MSG_TYPES; ++t) {
+            metrics.perf.type_totals[t] = perf_type_totals[t];
+            metrics.perf.type_counts[t] = perf_type_counts[t];
+        }
         
-        uint64_t sum = std::accumulate(latencies.begin(), latencies.end(), 0ULL);
-        metrics.latency_us.avg_us = (sum / n) / 1000.0;
+        const PerfSample& total = metrics.perf.total;
+        std::cout << "\n=== Perf Counters (per message, engine loop) ===" << std::endl;
+        for (size_t e = 0; e < PERF_EVENT_COUNT; ++e) {
+            if (!total.valid[e]) continue;
+            std::cout << std::left << std::setw(15) << perf_event_name(static_cast<PerfEvent>(e)) << std::right
+                      << std::setprecision(3) << static_cast<double>(total.values[e]) / applied << std::endl;
+        }
+        if (total.valid[0] && total.valid[1] && total[PerfEvent::Cycles] > 0) {
+            std::cout << std::left << std::setw(15) << "IPC" << std::right
+                      << static_cast<double>(total[PerfEvent::Instructions]) / total[PerfEvent::Cycles] << std::endl;
+        }
+        if (total.multiplexed) {
+            std::cout << "(counts scaled: the kernel multiplexed the counter group)" << std::endl;
+        }
+        if (perf_by_type) {
+            std::cout << "(per-type mode: two counter reads per message inflate engine time)" << std::endl;
+        }
+        std::cout << std::setprecision(2);
+    }
+    
+    if (track_latency && latency->all.count() > 0) {
+        const LatencyHistogram& all = latency->all;
+        auto us = [ticks_per_ns](double ticks) { return ticks / ticks_per_ns / 1000.0; };
+        metrics.latency_us.p50_us = us(all.percentile(50));
+        metrics.latency_us.p95_us = us(all.percentile(95));
+        metrics.latency_us.p99_us = us(all.percentile(99));
+        metrics.latency_us.p999_us = us(all.percentile(99.9));
+        metrics.latency_us.min_us = us(all.min());
+        metrics.latency_us.max_us = us(all.max());
+        metrics.latency_us.avg_us = us(all.mean());
         
         std::cout << "\n=== Latency Statistics (microseconds) ===" << std::endl;
         std::cout << "Min:    " << std::fixed << std::setprecision(2) << metrics.latency_us.min_us << " µs" << std::endl;
@@ -253,15 +970,27 @@ int main(int argc, char* argv[]) {
         std::cout << "P50:    " << metrics.latency_us.p50_us << " µs" << std::endl;
         std::cout << "P95:    " << metrics.latency_us.p95_us << " µs" << std::endl;
         std::cout << "P99:    " << metrics.latency_us.p99_us << " µs" << std::endl;
-        if (n > 1000) {
-            std::cout << "P99.9:  " << metrics.latency_us.p999_us << " µs" << std::endl;
-        }
+        std::cout << "P99.9:  " << metrics.latency_us.p999_us << " µs" << std::endl;
         std::cout << "Max:    " << metrics.latency_us.max_us << " µs" << std::endl;
         
-        if (messages.size() > 1'000'000) {
-            std::cout << "\nNote: Latency sampled at 1/" << LATENCY_SAMPLE_RATE 
-                      << " rate (" << n << " samples)" << std::endl;
-        }
+        std::cout << "\n=== Latency Breakdown (ns: count / p50 / p99 / p99.9) ===" << std::endl;
+        auto print_group = [&](const char* title, const LatencyHistogram* hs, const char* const* keys, size_t n) {
+            std::cout << title << ":" << std::endl;
+            for (size_t k = 0; k < n; ++k) {
+                if (hs[k].count() == 0) continue;
+                std::cout << "  " << std::left << std::setw(14) << keys[k] << std::right
+                          << std::setw(10) << hs[k].count()
+                          << std::setw(10) << std::setprecision(0) << hs[k].percentile(50) / ticks_per_ns
+                          << std::setw(10) << hs[k].percentile(99) / ticks_per_ns
+                          << std::setw(10) << hs[k].percentile(99.9) / ticks_per_ns
+                          << std::setprecision(2) << std::endl;
+            }
+        };
+        print_group("By type", latency->by_type, MSG_TYPE_NAMES, MSG_TYPES);
+        print_group("By outcome", latency->by_outcome, OUTCOME_NAMES, MSG_OUTCOME_COUNT);
+        print_group("By levels swept", latency->by_levels, SWEEP_NAMES, LatencyBreakdown::SWEEP_BUCKETS);
+        std::cout << "(TSC at " << std::setprecision(3) << ticks_per_ns << " ticks/ns, every message recorded)"
+                  << std::setprecision(2) << std::endl;
     } else if (!track_latency) {
         std::cout << "\nNote: Latency tracking disabled (use --no-latency to suppress this message)" << std::endl;
         // Set default values for metrics
@@ -271,18 +1000,7 @@ int main(int argc, char* argv[]) {
     
     // Write metrics JSON if requested
     if (!metrics_file.empty()) {
-        // Create results directory if needed
-        size_t last_slash = metrics_file.find_last_of("/\\");
-        if (last_slash != std::string::npos) {
-            std::string dir = metrics_file.substr(0, last_slash);
-            #ifdef _WIN32
-            system(("mkdir \"" + dir + "\" 2>nul").c_str());
-            #else
-            system(("mkdir -p \"" + dir + "\" 2>/dev/null").c_str());
-            #endif
-        }
-        write_metrics_json(metrics, metrics_file);
-        std::cout << "\nMetrics written to: " << metrics_file << std::endl;
+        save_metrics(metrics, metrics_file);
     }
     
     // Optional: print first few trades
@@ -291,13 +1009,11 @@ int main(int argc, char* argv[]) {
         size_t count = std::min(static_cast<size_t>(10), trades.size());
         for (size_t i = 0; i < count; ++i) {
             const auto& trade = trades[i];
-            auto ts_ms = std::chrono::duration_cast<std::chrono::microseconds>(
-                trade.ts.time_since_epoch()).count();
             std::cout << "Trade: buy_id=" << trade.buy_id 
                       << ", sell_id=" << trade.sell_id
                       << ", price=" << trade.price
                       << ", qty=" << trade.qty
-                      << ", ts=" << ts_ms << "us" << std::endl;
+                      << ", ts_ns=" << trade.ts_ns << std::endl;
         }
         if (trades.size() > count) {
             std::cout << "... (" << (trades.size() - count) << " more trades)" << std::endl;
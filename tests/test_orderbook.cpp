@@ -1,21 +1,87 @@
 #include "../include/OrderBook.h"
 #include "../include/Message.h"
+#include "../include/CSVReader.h"
+#include "../include/BinaryFormat.h"
+#include "../include/SPSCQueue.h"
+#include "../include/MatchingEngine.h"
+#include "../include/LatencyHistogram.h"
+#include "../include/PerfCounters.h"
+#include "../include/Snapshot.h"
+#include "../include/Journal.h"
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
 #include <iostream>
+#include <map>
 #include <chrono>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
-// Helper to create Msg with timestamp
+#ifndef _WIN32
+#include <csignal>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+// Helper to create Msg (event time 0 unless a test sets it)
 Msg make_msg(MsgType type, Side side, uint64_t id, int64_t price, int64_t qty) {
     Msg msg;
     msg.type = type;
     msg.side = side;
+    msg.tif = TimeInForce::GTC;
+    msg.symbol = 0;
     msg.id = id;
     msg.price = price;
     msg.qty = qty;
-    msg.ts = std::chrono::steady_clock::now();
+    msg.ts_ns = 0;
     return msg;
 }
 
+// Deterministic random flow: cancel_pct% cancels and modify_pct% Modify /
+// CancelReplace (including ids already filled or cancelled), 5% market
+// orders, the rest limits around 10000
+std::vector<Msg> make_random_flow(uint64_t seed, size_t count, uint64_t cancel_pct, uint64_t modify_pct = 0) {
+    std::vector<Msg> msgs;
+    auto next = [&seed] { seed = seed * 6364136223846793005ULL + 1442695040888963407ULL; return seed >> 33; };
+    OrderId next_id = 1;
+    for (size_t i = 0; i < count; ++i) {
+        Msg m{};
+        uint64_t r = next() % 100;
+        m.side = (next() & 1) ? Side::Buy : Side::Sell;
+        if (r < cancel_pct && next_id > 1) {
+            m.type = MsgType::Cancel;
+            m.id = 1 + next() % (next_id - 1);
+        } else if (r < cancel_pct + modify_pct && next_id > 1) {
+            m.type = (next() & 1) ? MsgType::Modify : MsgType::CancelReplace;
+            m.id = 1 + next() % (next_id - 1);
+            m.price = 10000 + static_cast<Price>(next() % 200) - 100;
+            m.qty = static_cast<Quantity>(next() % 50);  // 0 cancels
+        } else if (r < 95) {
+            m.type = MsgType::NewLimit;
+            m.id = next_id++;
+            m.price = 10000 + static_cast<Price>(next() % 200) - 100;
+            m.qty = 1 + next() % 50;
+        } else {
+            m.type = MsgType::NewMarket;
+            m.id = next_id++;
+            m.qty = 1 + next() % 100;
+        }
+        msgs.push_back(m);
+    }
+    return msgs;
+}
+
+std::string read_file(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
 // Test 1: Basic limit order matching
 void test_basic_matching() {
     OrderBook book;
@@ -132,6 +198,1508 @@ void test_empty_book_market_order() {
     std::cout << "✓ test_empty_book_market_order passed" << std::endl;
 }
 
+// Test 9: Levels outside the ladder window rest, match and re-center correctly
+void test_ladder_far_levels() {
+    BasicOrderBook<TradeCollector> book;   // reads get_trades()
+    
+    book.process_message(make_msg(MsgType::NewLimit, Side::Buy, 1, 100000, 10));
+    book.process_message(make_msg(MsgType::NewLimit, Side::Buy, 2, 50000, 10));   // far below
+    book.process_message(make_msg(MsgType::NewLimit, Side::Buy, 3, 900000, 10));  // far above: new touch
+    
+    assert(book.best_bid() == 900000);
+    assert(book.total_bid_qty() == 30);
+    
+    // Sweep all three levels with one aggressive sell
+    book.process_message(make_msg(MsgType::NewLimit, Side::Sell, 4, 1, 30));
+    
+    assert(book.get_total_trades() == 3);
+    assert(book.best_bid() == 0);
+    assert(book.best_ask() == 0);
+    
+    auto trades = book.get_trades();
+    assert(trades[0].price == 900000);
+    assert(trades[1].price == 100000);
+    assert(trades[2].price == 50000);
+    
+    std::cout << "✓ test_ladder_far_levels passed" << std::endl;
+}
+
+// Test 10: PriceLadder agrees with the std::map reference under random churn
+template <Side S>
+void check_ladder_against_map() {
+    PriceLadder<S> ladder(64);  // tiny window to force outliers and re-centering
+    MapBookSide<S> reference;
+    OrderPool pool;
+    std::mt19937_64 rng(42);
+    
+    Price mid = 10000;
+    for (size_t i = 0; i < 4096; ++i) {
+        mid += static_cast<Price>(rng() % 21) - 10;
+        Price price = mid + static_cast<Price>(rng() % 201) - 100;
+        
+        if (rng() % 3 == 0 && !reference.empty()) {
+            Price best = reference.best_price();
+            assert(ladder.best_price() == best);
+            ladder.erase(best);
+            reference.erase(best);
+        } else {
+            ladder.get_or_create(price).add_order(pool.allocate(i, 1));
+            reference.get_or_create(price).add_order(pool.allocate(i, 1));
+        }
+        
+        assert(ladder.level_count() == reference.level_count());
+        if (!reference.empty()) {
+            assert(ladder.best_price() == reference.best_price());
+            assert(ladder.best_level().total_qty() == reference.best_level().total_qty());
+        }
+    }
+    
+    std::vector<Price> a, b;
+    ladder.for_each([&](Price p, const PriceLevel&) { a.push_back(p); });
+    reference.for_each([&](Price p, const PriceLevel&) { b.push_back(p); });
+    assert(a == b);
+}
+
+void test_ladder_matches_map() {
+    check_ladder_against_map<Side::Buy>();
+    check_ladder_against_map<Side::Sell>();
+    
+    std::cout << "✓ test_ladder_matches_map passed" << std::endl;
+}
+
+// Test 11: Filled and cancelled orders return their pool slots (LIFO reuse)
+void test_pool_recycles_orders() {
+    OrderBook book;
+    
+    book.process_message(make_msg(MsgType::NewLimit, Side::Buy, 1, 100, 10));
+    book.process_message(make_msg(MsgType::NewLimit, Side::Buy, 2, 99, 10));
+    assert(book.pool_stats().in_use == 2);
+    
+    // Aggressive order that fills on arrival never takes a slot
+    book.process_message(make_msg(MsgType::NewLimit, Side::Sell, 3, 100, 10));
+    assert(book.pool_stats().in_use == 1);
+    
+    book.process_message(make_msg(MsgType::Cancel, Side::Buy, 2, 0, 0));
+    assert(book.pool_stats().in_use == 0);
+    assert(book.pool_stats().high_water_mark == 2);
+    
+    // Churn far beyond one chunk without ever holding more than one order
+    for (uint64_t id = 10; id < 10 + 3 * OrderPool::DEFAULT_CHUNK_ORDERS; ++id) {
+        book.process_message(make_msg(MsgType::NewLimit, Side::Sell, id, 105, 1));
+        book.process_message(make_msg(MsgType::Cancel, Side::Sell, id, 0, 0));
+    }
+    PoolStats stats = book.pool_stats();
+    assert(stats.in_use == 0);
+    assert(stats.high_water_mark == 2);
+    assert(stats.chunks == 1);
+    
+    std::cout << "✓ test_pool_recycles_orders passed" << std::endl;
+}
+
+// Test 12: Both id-index backends agree with std::unordered_map
+template <typename Index>
+void check_index_against_map(Index index) {
+    std::unordered_map<OrderId, Order*> reference;
+    std::vector<OrderId> live;
+    std::vector<Order> orders(8);
+    std::mt19937_64 rng(7);
+    OrderId next_id = 1;
+    
+    for (int step = 0; step < 200000; ++step) {
+        uint64_t roll = rng() % 100;
+        if (roll < 45) {
+            // Mostly dense ids, with occasional jumps and stale ids
+            OrderId id = next_id++;
+            if (roll < 2) id = next_id += 1000;
+            if (roll == 2 && next_id > 500) id = next_id - 500 - rng() % 10;
+            Order* o = &orders[rng() % orders.size()];
+            index.insert(id, o);
+            if (reference.insert_or_assign(id, o).second) live.push_back(id);
+        } else if (roll < 90 && !live.empty()) {
+            size_t k = rng() % live.size();
+            OrderId id = live[k];
+            live[k] = live.back();
+            live.pop_back();
+            assert(index.extract(id) == reference[id]);
+            reference.erase(id);
+            assert(index.find(id) == nullptr);
+        } else {
+            OrderId id = rng() % (next_id + 10);
+            auto it = reference.find(id);
+            assert(index.find(id) == (it == reference.end() ? nullptr : it->second));
+        }
+        assert(index.size() == reference.size());
+    }
+}
+
+void test_order_index_backends() {
+    check_index_against_map(FlatOrderIndex(16));
+    check_index_against_map(WindowOrderIndex(64));
+    
+    std::cout << "✓ test_order_index_backends passed" << std::endl;
+}
+
+// Test 13: In-place CSV line parser (tokens, whitespace, CRLF, comments)
+void test_csv_parse_line() {
+    const std::string text =
+        "# ts_ns,MsgType,Side,OrderId,Price,Qty\n"
+        "ts_ns,MsgType,Side,OrderId,Price,Qty\n"
+        "1693526400000000000,NewLimit,Buy,1,100050,10\n"
+        " 1693526400001000000 , NewMarket , Sell , 2 , 0 , 7 , 17 \r\n"
+        "\n"
+        "1693526400002000000,Cancel,Sell,123456789012,-5,0\n"
+        "1693526400003000000,Modify,Buy,1,100049,6\n"
+        "1693526400004000000,CancelReplace,Buy,1,100051,12\n"
+        "1693526400005000000,NewLimit,Sell,3,100050,10,,IOC\n"
+        "1693526400006000000,NewLimit,Buy,4,100048,10,3,PostOnly";
+    const char* p = text.data();
+    const char* end = p + text.size();
+    Msg msg;
+    
+    assert(CSVReader::parse_line(p, end, msg) == CSVReader::LineStatus::Skip);
+    assert(CSVReader::parse_line(p, end, msg) == CSVReader::LineStatus::Malformed);
+    
+    assert(CSVReader::parse_line(p, end, msg) == CSVReader::LineStatus::Message);
+    assert(msg.ts_ns == 1693526400000000000ULL);
+    assert(msg.type == MsgType::NewLimit && msg.side == Side::Buy);
+    assert(msg.id == 1 && msg.price == 100050 && msg.qty == 10);
+    assert(msg.tif == TimeInForce::GTC);
+    
+    assert(CSVReader::parse_line(p, end, msg) == CSVReader::LineStatus::Message);
+    assert(msg.ts_ns == 1693526400001000000ULL);
+    assert(msg.type == MsgType::NewMarket && msg.side == Side::Sell);
+    assert(msg.id == 2 && msg.price == 0 && msg.qty == 7 && msg.symbol == 17);
+    
+    assert(CSVReader::parse_line(p, end, msg) == CSVReader::LineStatus::Skip);
+    
+    assert(CSVReader::parse_line(p, end, msg) == CSVReader::LineStatus::Message);
+    assert(msg.type == MsgType::Cancel && msg.id == 123456789012ULL && msg.price == -5);
+    assert(msg.symbol == 0);
+    
+    assert(CSVReader::parse_line(p, end, msg) == CSVReader::LineStatus::Message);
+    assert(msg.type == MsgType::Modify && msg.id == 1 && msg.price == 100049 && msg.qty == 6);
+    assert(CSVReader::parse_line(p, end, msg) == CSVReader::LineStatus::Message);
+    assert(msg.type == MsgType::CancelReplace && msg.id == 1 && msg.price == 100051 && msg.qty == 12);
+    assert(CSVReader::parse_line(p, end, msg) == CSVReader::LineStatus::Message);
+    assert(msg.id == 3 && msg.symbol == 0 && msg.tif == TimeInForce::IOC);
+    assert(CSVReader::parse_line(p, end, msg) == CSVReader::LineStatus::Message);
+    assert(msg.id == 4 && msg.symbol == 3 && msg.tif == TimeInForce::PostOnly);
+    assert(p == end);
+    
+    // Numbers that do not fit their field are malformed, not wrapped
+    const std::string ranges =
+        "18446744073709551615,NewLimit,Buy,00000000000000000000007,-9223372036854775808,9223372036854775807\n"
+        "18446744073709551616,NewLimit,Buy,1,100,1\n"
+        "1,NewLimit,Buy,123456789012345678901234,100,1\n"
+        "1,NewLimit,Buy,1,-9223372036854775809,1\n"
+        "1,NewLimit,Buy,1,100,9223372036854775808\n";
+    p = ranges.data();
+    end = p + ranges.size();
+    assert(CSVReader::parse_line(p, end, msg) == CSVReader::LineStatus::Message);
+    assert(msg.ts_ns == UINT64_MAX && msg.id == 7 && msg.price == INT64_MIN && msg.qty == INT64_MAX);
+    for (int i = 0; i < 4; ++i) {
+        assert(CSVReader::parse_line(p, end, msg) == CSVReader::LineStatus::Malformed);
+    }
+    assert(p == end);
+    
+    std::cout << "✓ test_csv_parse_line passed" << std::endl;
+}
+
+// Test 14: Binary records round-trip every Msg field
+void test_binary_record_roundtrip() {
+    Msg in = make_msg(MsgType::NewMarket, Side::Sell, 987654321, -42, 1234);
+    in.symbol = 4242;
+    in.tif = TimeInForce::FOK;
+    in.ts_ns = 1693526400000000007ULL;
+    BinaryMsgRecord rec = to_binary_record(in);
+    
+    Msg out{};
+    to_msg(rec, out);
+    assert(rec.ts_ns == 1693526400000000007ULL);
+    assert(out.type == in.type && out.side == in.side);
+    assert(out.id == in.id && out.price == in.price && out.qty == in.qty);
+    assert(out.symbol == 4242 && out.tif == TimeInForce::FOK);
+    assert(out.ts_ns == 1693526400000000007ULL);
+    
+    std::cout << "✓ test_binary_record_roundtrip passed" << std::endl;
+}
+
+// A binary file with an undecodable record (unknown type or side, reserved
+// flag bits) is rejected on open instead of feeding enum values past the end
+void test_binary_file_rejects_invalid_records() {
+    const std::string path = "test_binary_invalid.bin";
+    auto write_file = [&path](const std::vector<BinaryMsgRecord>& records) {
+        BinaryFileHeader header{};
+        std::memcpy(header.magic, BINARY_MAGIC, sizeof(BINARY_MAGIC));
+        header.version = BINARY_VERSION;
+        header.record_size = sizeof(BinaryMsgRecord);
+        header.msg_count = records.size();
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(BinaryMsgRecord));
+    };
+    std::vector<BinaryMsgRecord> records;
+    for (uint64_t id = 1; id <= 3; ++id) {
+        records.push_back(to_binary_record(make_msg(MsgType::NewLimit, Side::Buy, id, 1000, 5)));
+    }
+    write_file(records);
+    assert(BinaryMessageFile(path).is_valid() && BinaryMessageFile(path).size() == 3);
+    
+    BinaryMsgRecord good = records[1];
+    records[1].type = 200;
+    write_file(records);
+    assert(!BinaryMessageFile(path).is_valid());
+    records[1] = good;
+    records[1].side = 2;
+    write_file(records);
+    assert(!BinaryMessageFile(path).is_valid());
+    records[1] = good;
+    records[1].flags = 0x4;
+    write_file(records);
+    assert(!BinaryMessageFile(path).is_valid());
+    
+    // A record count whose byte size wraps is caught as truncation
+    records[1] = good;
+    write_file(records);
+    {
+        std::fstream io(path, std::ios::binary | std::ios::in | std::ios::out);
+        uint64_t count = UINT64_MAX / sizeof(BinaryMsgRecord) + 2;
+        io.seekp(offsetof(BinaryFileHeader, msg_count));
+        io.write(reinterpret_cast<const char*>(&count), sizeof(count));
+    }
+    assert(!BinaryMessageFile(path).is_valid());
+    std::remove(path.c_str());
+    
+    std::cout << "✓ test_binary_file_rejects_invalid_records passed" << std::endl;
+}
+
+// Parser thread -> small ring -> consumer must see exactly what the
+// whole-file mmap reader loads, with lines straddling buffer refills
+void test_stream_reader_through_ring() {
+    const std::string path = "test_stream_reader.csv";
+    {
+        std::ofstream out(path);
+        out << "ts_ns,MsgType,Side,OrderId,Price,Qty\n";
+        std::mt19937_64 rng(7);
+        for (int i = 1; i <= 5000; ++i) {
+            const char* type = (i % 7 == 0) ? "Cancel" : (i % 11 == 0) ? "NewMarket" : "NewLimit";
+            out << 1693526400000000000ULL + i << "," << type << "," << ((rng() & 1) ? "Buy" : "Sell")
+                << "," << i << "," << 100000 + static_cast<int64_t>(rng() % 200) << "," << 1 + rng() % 50;
+            out << ((i % 3 == 0) ? "\r\n" : "\n");
+        }
+        out << "garbage line\n";  // no trailing newline after the last record
+        out << "1693526400000009999,NewLimit,Sell,9999,100100,5";
+    }
+    
+    std::vector<Msg> expected = CSVReader::read_messages_mmap(path);
+    assert(expected.size() == 5001);
+    
+    CSVStreamReader reader(path, 96);  // a couple of lines per refill
+    assert(reader.is_open());
+    SPSCQueue<Msg> ring(8);
+    
+    std::thread parser([&] {
+        for (;;) {
+            Msg* slots;
+            size_t room = ring.claim(slots, 5);
+            if (room == 0) {
+                std::this_thread::yield();
+                continue;
+            }
+            size_t parsed = reader.next_batch(slots, room);
+            if (parsed == 0) break;
+            ring.publish(parsed);
+        }
+        ring.close();
+    });
+    
+    std::vector<Msg> streamed;
+    for (;;) {
+        const Msg* batch;
+        size_t n = ring.peek(batch, 3);
+        if (n == 0) {
+            if (ring.drained()) break;
+            std::this_thread::yield();
+            continue;
+        }
+        streamed.insert(streamed.end(), batch, batch + n);
+        ring.release(n);
+    }
+    parser.join();
+    std::remove(path.c_str());
+    
+    assert(streamed.size() == expected.size());
+    for (size_t i = 0; i < expected.size(); ++i) {
+        assert(streamed[i].type == expected[i].type && streamed[i].side == expected[i].side);
+        assert(streamed[i].id == expected[i].id);
+        assert(streamed[i].price == expected[i].price && streamed[i].qty == expected[i].qty);
+    }
+    assert(reader.malformed() == 1);
+    
+    std::cout << "✓ test_stream_reader_through_ring passed" << std::endl;
+}
+
+// Sharded engine must leave every symbol's book exactly as a standalone
+// OrderBook fed that symbol's messages in order
+void test_matching_engine_symbols() {
+    const uint32_t SYMBOLS = 5;
+    std::mt19937_64 rng(11);
+    std::vector<Msg> feed;
+    std::vector<std::vector<uint64_t>> live(SYMBOLS);
+    
+    for (uint64_t id = 1; id <= 20000; ++id) {
+        uint32_t symbol = static_cast<uint32_t>(rng() % SYMBOLS);
+        Side side = (rng() & 1) ? Side::Buy : Side::Sell;
+        uint64_t roll = rng() % 10;
+        Msg msg;
+        if (roll < 2 && !live[symbol].empty()) {
+            size_t k = rng() % live[symbol].size();
+            msg = make_msg(MsgType::Cancel, side, live[symbol][k], 0, 0);
+            live[symbol][k] = live[symbol].back();
+            live[symbol].pop_back();
+        } else if (roll < 3) {
+            msg = make_msg(MsgType::NewMarket, side, id, 0, 1 + static_cast<int64_t>(rng() % 20));
+        } else {
+            msg = make_msg(MsgType::NewLimit, side, id, 1000 + static_cast<int64_t>(rng() % 40),
+                           1 + static_cast<int64_t>(rng() % 20));
+            live[symbol].push_back(id);
+        }
+        msg.symbol = symbol;
+        feed.push_back(msg);
+    }
+    
+    MatchingEngine engine(2, 64);  // small queues force dispatcher back-pressure
+    std::vector<std::unique_ptr<OrderBook>> reference;
+    for (uint32_t s = 0; s < SYMBOLS; ++s) reference.push_back(std::make_unique<OrderBook>());
+    for (const Msg& msg : feed) {
+        assert(engine.submit(msg));
+        reference[msg.symbol]->process_message(msg);
+    }
+    
+    Msg bad = make_msg(MsgType::NewLimit, Side::Buy, 1, 1000, 1);
+    bad.symbol = MatchingEngine::MAX_SYMBOLS;
+    assert(!engine.submit(bad));
+    
+    engine.stop();
+    assert(engine.symbol_count() == SYMBOLS);
+    assert(engine.rejected() == 1);
+    
+    uint64_t routed = 0;
+    for (size_t w = 0; w < engine.worker_count(); ++w) routed += engine.worker_stats(w).messages;
+    assert(routed == feed.size());
+    
+    for (uint32_t s = 0; s < SYMBOLS; ++s) {
+        const ShardBook* book = engine.book(s);
+        const OrderBook& ref = *reference[s];
+        assert(book != nullptr);
+        assert(book->get_total_messages() == ref.get_total_messages());
+        assert(book->get_total_trades() == ref.get_total_trades());
+        assert(book->best_bid() == ref.best_bid() && book->best_bid_qty() == ref.best_bid_qty());
+        assert(book->best_ask() == ref.best_ask() && book->best_ask_qty() == ref.best_ask_qty());
+        assert(book->total_bid_qty() == ref.total_bid_qty());
+        assert(book->total_ask_qty() == ref.total_ask_qty());
+    }
+    assert(engine.book(SYMBOLS + 7) == nullptr);
+    
+    std::cout << "✓ test_matching_engine_symbols passed" << std::endl;
+}
+
+// Handler policy: events arrive inline, and a NullEventHandler book ends in
+// the same state as the trade-collecting one
+struct RecordingHandler : NullEventHandler {
+    std::vector<Trade> trades;
+    std::vector<uint64_t> accepted, rested, cancelled, modified, killed;
+    Quantity cancelled_qty = 0;
+    Quantity killed_qty = 0;
+    
+    void on_trade(const Trade& trade) { trades.push_back(trade); }
+    void on_order_accepted(OrderId id, Side, Price, Quantity) { accepted.push_back(id); }
+    void on_order_rested(const Order& order) { rested.push_back(order.id()); }
+    void on_order_cancelled(const Order& order) {
+        cancelled.push_back(order.id());
+        cancelled_qty += order.qty;
+    }
+    void on_order_modified(OrderId id, Side, Price, Quantity, Price, Quantity) { modified.push_back(id); }
+    void on_order_killed(OrderId id, Side, Price, Quantity qty) {
+        killed.push_back(id);
+        killed_qty += qty;
+    }
+};
+
+void test_event_handler_policy() {
+    BasicOrderBook<RecordingHandler> book;
+    BasicOrderBook<NullEventHandler> null_book;
+    std::vector<Msg> msgs = {
+        make_msg(MsgType::NewLimit, Side::Sell, 1, 100, 10),
+        make_msg(MsgType::NewLimit, Side::Sell, 2, 101, 5),
+        make_msg(MsgType::NewLimit, Side::Buy, 3, 100, 4),     // fills 4 of #1, nothing rests
+        make_msg(MsgType::NewMarket, Side::Buy, 4, 0, 8),      // 6 from #1, 2 from #2
+        make_msg(MsgType::Cancel, Side::Sell, 2, 0, 0),        // 3 left on #2
+        make_msg(MsgType::Cancel, Side::Sell, 99, 0, 0),       // unknown id: no event
+        make_msg(MsgType::NewLimit, Side::Buy, 5, 99, 7),
+    };
+    for (const Msg& msg : msgs) {
+        book.process_message(msg);
+        null_book.process_message(msg);
+    }
+    
+    const RecordingHandler& h = book.handler();
+    assert((h.accepted == std::vector<uint64_t>{1, 2, 3, 4, 5}));
+    assert((h.rested == std::vector<uint64_t>{1, 2, 5}));
+    assert((h.cancelled == std::vector<uint64_t>{2}) && h.cancelled_qty == 3);
+    assert(h.trades.size() == 3 && book.get_total_trades() == 3);
+    assert(h.trades[0].buy_id == 3 && h.trades[0].sell_id == 1 && h.trades[0].qty == 4);
+    assert(h.trades[1].buy_id == 4 && h.trades[1].sell_id == 1 && h.trades[1].qty == 6);
+    assert(h.trades[2].buy_id == 4 && h.trades[2].sell_id == 2 && h.trades[2].price == 101);
+    assert(book.get_trades().empty());  // RecordingHandler is not a collector
+    
+    assert(null_book.get_total_trades() == 3);
+    assert(null_book.get_trades().empty());
+    assert(null_book.best_bid() == 99 && null_book.best_bid_qty() == 7);
+    assert(null_book.best_ask() == book.best_ask() && null_book.best_ask() == 0);
+    
+    std::cout << "✓ test_event_handler_policy passed" << std::endl;
+}
+
+// L2 deltas: raw per-change feed, conflated per message and per batch; a
+// depth map rebuilt from conflated deltas must match the book
+void test_l2_deltas_and_conflation() {
+    auto same = [](const L2Delta& d, Side side, L2Action action, Price price, Quantity qty, uint32_t orders) {
+        return d.side == side && d.action == action && d.price == price && d.qty == qty && d.orders == orders;
+    };
+    std::vector<Msg> msgs = {
+        make_msg(MsgType::NewLimit, Side::Sell, 1, 100, 10),
+        make_msg(MsgType::NewLimit, Side::Sell, 2, 100, 5),
+        make_msg(MsgType::NewLimit, Side::Sell, 3, 101, 5),
+        make_msg(MsgType::NewLimit, Side::Buy, 4, 101, 18),  // sweeps 100, 3 from 101
+    };
+    
+    BasicOrderBook<L2DeltaCollector> raw;
+    for (const Msg& msg : msgs) raw.process_message(msg);
+    const auto& r = raw.handler().deltas();
+    // Level 100 is taken whole: one Delete, no per-fill Modify
+    assert(r.size() == 5);
+    assert(same(r[0], Side::Sell, L2Action::Add, 100, 10, 1));
+    assert(same(r[1], Side::Sell, L2Action::Modify, 100, 15, 2));
+    assert(same(r[2], Side::Sell, L2Action::Add, 101, 5, 1));
+    assert(same(r[3], Side::Sell, L2Action::Delete, 100, 0, 0));
+    assert(same(r[4], Side::Sell, L2Action::Modify, 101, 2, 1));
+    
+    BasicOrderBook<L2Conflator<L2DeltaCollector>> per_msg;
+    for (size_t i = 0; i < 3; ++i) per_msg.process_message(msgs[i]);
+    per_msg.handler().sink().clear();
+    per_msg.process_message(msgs[3]);
+    const auto& m = per_msg.handler().sink().deltas();
+    assert(m.size() == 2);
+    assert(same(m[0], Side::Sell, L2Action::Delete, 100, 0, 0));
+    assert(same(m[1], Side::Sell, L2Action::Modify, 101, 2, 1));
+    
+    BasicOrderBook<L2Conflator<L2DeltaCollector>> per_batch(
+        L2Conflator<L2DeltaCollector>(ConflationWindow::Batch));
+    for (const Msg& msg : msgs) per_batch.process_message(msg);
+    assert(per_batch.handler().sink().deltas().empty());
+    per_batch.handler().flush();
+    const auto& b = per_batch.handler().sink().deltas();
+    assert(b.size() == 1);  // level 100 came and went inside the batch
+    assert(same(b[0], Side::Sell, L2Action::Add, 101, 2, 1));
+    assert(per_batch.handler().received() == 5 && per_batch.handler().published() == 1);
+    
+    // Random flow, flushed every 16 messages: rebuilt depth matches the book
+    BasicOrderBook<L2Conflator<L2DeltaCollector>> book(
+        L2Conflator<L2DeltaCollector>(ConflationWindow::Batch));
+    std::map<Price, Quantity> bid_depth, ask_depth;
+    std::mt19937_64 rng(5);
+    std::vector<uint64_t> live;
+    for (uint64_t id = 1; id <= 20000; ++id) {
+        Side side = (rng() & 1) ? Side::Buy : Side::Sell;
+        uint64_t roll = rng() % 10;
+        if (roll < 3 && !live.empty()) {
+            size_t k = rng() % live.size();
+            book.process_message(make_msg(MsgType::Cancel, side, live[k], 0, 0));
+            live[k] = live.back();
+            live.pop_back();
+        } else if (roll < 4) {
+            book.process_message(make_msg(MsgType::NewMarket, side, id, 0, 1 + static_cast<int64_t>(rng() % 30)));
+        } else {
+            int64_t price = side == Side::Buy ? 990 + static_cast<int64_t>(rng() % 15)
+                                              : 996 + static_cast<int64_t>(rng() % 15);
+            book.process_message(make_msg(MsgType::NewLimit, side, id, price, 1 + static_cast<int64_t>(rng() % 20)));
+            live.push_back(id);
+        }
+        
+        if (id % 16 == 0) {
+            book.handler().flush();
+            for (const L2Delta& d : book.handler().sink().deltas()) {
+                auto& depth = d.side == Side::Buy ? bid_depth : ask_depth;
+                if (d.action == L2Action::Add) assert(depth.count(d.price) == 0);
+                if (d.action != L2Action::Add) assert(depth.count(d.price) == 1);
+                if (d.action == L2Action::Delete) depth.erase(d.price);
+                else depth[d.price] = d.qty;
+            }
+            book.handler().sink().clear();
+            
+            Quantity bid_total = 0, ask_total = 0;
+            for (const auto& [price, qty] : bid_depth) bid_total += qty;
+            for (const auto& [price, qty] : ask_depth) ask_total += qty;
+            assert(bid_total == book.total_bid_qty() && ask_total == book.total_ask_qty());
+            assert(bid_depth.empty() ? book.best_bid() == 0 : bid_depth.rbegin()->first == book.best_bid());
+            assert(ask_depth.empty() ? book.best_ask() == 0 : ask_depth.begin()->first == book.best_ask());
+        }
+    }
+    assert(book.handler().published() < book.handler().received());
+    
+    // Market-data-only handlers skip the trade clock; trade consumers keep it
+    static_assert(discards_trades_v<NullEventHandler> && discards_trades_v<L2Conflator<L2DeltaCollector>>);
+    static_assert(!discards_trades_v<TradeCollector> && !discards_trades_v<RecordingHandler>);
+    static_assert(!discards_trades_v<EventFanout<L2DeltaCollector, TradeCollector>>);
+    
+    std::cout << "✓ test_l2_deltas_and_conflation passed" << std::endl;
+}
+
+// Top-N depth: snapshot_depth matches a depth map rebuilt from raw deltas,
+// and the seqlock-published DepthPublisher copy matches the book after every
+// message, also while another thread keeps reading it
+void test_depth_snapshot_and_publisher() {
+    constexpr size_t N = 5;
+    using Handler = EventFanout<L2DeltaCollector, DepthPublisher<N>>;
+    SeqlockDepth<N> published;
+    BasicOrderBook<Handler> book{Handler(L2DeltaCollector(), DepthPublisher<N>(&published))};
+    
+    std::atomic<bool> done{false};
+    std::atomic<uint64_t> reads{0};
+    std::thread reader([&] {
+        DepthSnapshot<N> snap;
+        uint64_t last_sequence = 0;
+        do {
+            published.read(snap);
+            assert(snap.sequence >= last_sequence);
+            last_sequence = snap.sequence;
+            assert(snap.bids.levels <= N && snap.asks.levels <= N);
+            for (uint32_t i = 1; i < snap.bids.levels; ++i) assert(snap.bids.prices[i] < snap.bids.prices[i - 1]);
+            for (uint32_t i = 1; i < snap.asks.levels; ++i) assert(snap.asks.prices[i] > snap.asks.prices[i - 1]);
+            for (uint32_t i = 0; i < snap.bids.levels; ++i) assert(snap.bids.qtys[i] > 0 && snap.bids.order_counts[i] > 0);
+            reads.fetch_add(1, std::memory_order_relaxed);
+        } while (!done.load(std::memory_order_acquire));
+    });
+    
+    std::map<Price, std::pair<Quantity, uint32_t>> bid_depth, ask_depth;
+    std::mt19937_64 rng(9);
+    std::vector<uint64_t> live;
+    for (uint64_t id = 1; id <= 20000; ++id) {
+        Side side = (rng() & 1) ? Side::Buy : Side::Sell;
+        uint64_t roll = rng() % 10;
+        if (roll < 3 && !live.empty()) {
+            size_t k = rng() % live.size();
+            book.process_message(make_msg(MsgType::Cancel, side, live[k], 0, 0));
+            live[k] = live.back();
+            live.pop_back();
+        } else if (roll < 4) {
+            book.process_message(make_msg(MsgType::NewMarket, side, id, 0, 1 + static_cast<int64_t>(rng() % 30)));
+        } else {
+            int64_t price = side == Side::Buy ? 980 + static_cast<int64_t>(rng() % 25)
+                                              : 996 + static_cast<int64_t>(rng() % 25);
+            book.process_message(make_msg(MsgType::NewLimit, side, id, price, 1 + static_cast<int64_t>(rng() % 20)));
+            live.push_back(id);
+        }
+        
+        for (const L2Delta& d : book.handler().first().deltas()) {
+            auto& depth = d.side == Side::Buy ? bid_depth : ask_depth;
+            if (d.action == L2Action::Delete) depth.erase(d.price);
+            else depth[d.price] = {d.qty, d.orders};
+        }
+        book.handler().first().clear();
+        
+        Price bid_prices[N], ask_prices[N];
+        Quantity bid_qtys[N], ask_qtys[N];
+        uint32_t bid_counts[N], ask_counts[N];
+        DepthLevels levels = book.snapshot_depth(N, {bid_prices, bid_qtys, bid_counts},
+                                                 {ask_prices, ask_qtys, ask_counts});
+        assert(levels.bids == std::min(N, bid_depth.size()));
+        assert(levels.asks == std::min(N, ask_depth.size()));
+        auto bid_it = bid_depth.rbegin();
+        for (size_t i = 0; i < levels.bids; ++i, ++bid_it) {
+            assert(bid_prices[i] == bid_it->first && bid_qtys[i] == bid_it->second.first);
+            assert(bid_counts[i] == bid_it->second.second);
+        }
+        auto ask_it = ask_depth.begin();
+        for (size_t i = 0; i < levels.asks; ++i, ++ask_it) {
+            assert(ask_prices[i] == ask_it->first && ask_qtys[i] == ask_it->second.first);
+            assert(ask_counts[i] == ask_it->second.second);
+        }
+        
+        // Materialized copy is current after every message
+        const DepthSnapshot<N>& mirror = book.handler().second().depth();
+        assert(mirror.bids.levels == levels.bids && mirror.asks.levels == levels.asks);
+        for (size_t i = 0; i < levels.bids; ++i) {
+            assert(mirror.bids.prices[i] == bid_prices[i] && mirror.bids.qtys[i] == bid_qtys[i]);
+        }
+        for (size_t i = 0; i < levels.asks; ++i) {
+            assert(mirror.asks.prices[i] == ask_prices[i] && mirror.asks.qtys[i] == ask_qtys[i]);
+        }
+    }
+    
+    done.store(true, std::memory_order_release);
+    reader.join();
+    
+    DepthSnapshot<N> last;
+    published.read(last);
+    assert(std::memcmp(&last, &book.handler().second().depth(), sizeof(last)) == 0);
+    assert(published.version() == book.handler().second().published());
+    assert(book.handler().second().published() < book.get_total_messages());  // deep churn skipped
+    assert(reads.load() > 0);
+    
+    std::cout << "✓ test_depth_snapshot_and_publisher passed" << std::endl;
+}
+
+void test_process_batch_matches_sequential() {
+    // Random flow with many cancels (including ids already gone) so every
+    // prefetch stage is exercised; batching must not change any outcome
+    std::vector<Msg> msgs = make_random_flow(7, 20000, 40);
+    
+    BasicOrderBook<TradeCollector> reference;   // compares get_trades()
+    for (const Msg& m : msgs) reference.process_message(m);
+    
+    for (size_t lookahead : {size_t(0), size_t(1), size_t(3), size_t(8), size_t(64), size_t(1000)}) {
+        BasicOrderBook<TradeCollector> book;
+        // Uneven chunks so pipelines start and drain at arbitrary points
+        for (size_t pos = 0; pos < msgs.size(); pos += 777) {
+            size_t len = std::min<size_t>(777, msgs.size() - pos);
+            book.process_batch(std::span<const Msg>(msgs.data() + pos, len), lookahead);
+        }
+        
+        const auto& got = book.get_trades();
+        const auto& want = reference.get_trades();
+        assert(got.size() == want.size());
+        for (size_t i = 0; i < got.size(); ++i) {
+            assert(got[i].buy_id == want[i].buy_id && got[i].sell_id == want[i].sell_id);
+            assert(got[i].price == want[i].price && got[i].qty == want[i].qty);
+        }
+        assert(book.get_total_messages() == reference.get_total_messages());
+        assert(book.best_bid() == reference.best_bid() && book.best_ask() == reference.best_ask());
+        assert(book.total_bid_qty() == reference.total_bid_qty());
+        assert(book.total_ask_qty() == reference.total_ask_qty());
+    }
+    
+    std::cout << "✓ test_process_batch_matches_sequential passed" << std::endl;
+}
+
+// Trades carry the aggressor's input timestamp, not replay wall time
+void test_trades_carry_event_time() {
+    BasicOrderBook<TradeCollector> book;   // reads get_trades()
+    Msg rest = make_msg(MsgType::NewLimit, Side::Sell, 1, 100, 10);
+    rest.ts_ns = 1000;
+    Msg take = make_msg(MsgType::NewLimit, Side::Buy, 2, 100, 4);
+    take.ts_ns = 2000;
+    Msg sweep = make_msg(MsgType::NewMarket, Side::Buy, 3, 0, 6);
+    sweep.ts_ns = 3000;
+    book.process_message(rest);
+    book.process_message(take);
+    book.process_message(sweep);
+    
+    const auto& trades = book.get_trades();
+    assert(trades.size() == 2);
+    assert(trades[0].ts_ns == 2000 && trades[1].ts_ns == 3000);
+    if constexpr (MATCH_CLOCK == ClockSource::None) {
+        assert(trades[0].match_ts == 0 && trades[1].match_ts == 0);
+    } else {
+        assert(trades[1].match_ts >= trades[0].match_ts);
+    }
+    
+    uint64_t s0 = clock_now<ClockSource::Steady>();
+    uint64_t t0 = clock_now<ClockSource::Tsc>();
+    assert(clock_now<ClockSource::Steady>() >= s0);
+    assert(clock_now<ClockSource::Tsc>() >= t0);
+    assert(clock_now<ClockSource::None>() == 0);
+    
+    std::cout << "✓ test_trades_carry_event_time passed" << std::endl;
+}
+
+// Log-linear histogram: bucket bounds, bounded relative error, percentiles
+void test_latency_histogram() {
+    using H = LatencyHistogram;
+    // Buckets tile the value range with no gaps and ~3% width
+    for (size_t idx = 1; idx < H::BUCKETS; ++idx) {
+        assert(H::bucket_upper(idx) > H::bucket_upper(idx - 1));
+        assert(H::bucket_index(H::bucket_upper(idx - 1) + 1) == idx);
+        assert(H::bucket_index(H::bucket_upper(idx)) == idx);
+    }
+    for (uint64_t v : {uint64_t(0), uint64_t(63), uint64_t(64), uint64_t(1000), uint64_t(123456789)}) {
+        uint64_t upper = H::bucket_upper(H::bucket_index(v));
+        assert(upper >= v && upper - v <= v / H::SUB_BUCKETS);
+    }
+    assert(H::bucket_index(UINT64_MAX) == H::BUCKETS - 1);
+    
+    auto h = std::make_unique<H>();
+    assert(h->percentile(50) == 0 && h->min() == 0);
+    for (uint64_t v = 1; v <= 10000; ++v) h->record(v);
+    assert(h->count() == 10000 && h->min() == 1 && h->max() == 10000);
+    assert(h->mean() == 5000.5);
+    for (double p : {50.0, 90.0, 99.0, 99.9}) {
+        double exact = p / 100.0 * 10000;
+        double got = static_cast<double>(h->percentile(p));
+        assert(got >= exact && got <= exact * (1.0 + 1.0 / H::SUB_BUCKETS) + 1);
+    }
+    assert(h->percentile(100) == 10000);
+    
+    auto other = std::make_unique<H>();
+    other->record(1'000'000);
+    h->merge(*other);
+    assert(h->count() == 10001 && h->max() == 1'000'000);
+    assert(h->percentile(100) == 1'000'000);
+    
+    std::cout << "✓ test_latency_histogram passed" << std::endl;
+}
+
+// Perf counters open what the host exposes and degrade to "unavailable"
+// (with a reason) elsewhere, e.g. in VMs without a PMU
+void test_perf_counters() {
+    PerfCounters perf;
+    perf.start();
+    volatile uint64_t sink = 0;
+    for (uint64_t i = 0; i < 100000; ++i) sink = sink + i;
+    perf.stop();
+    PerfSample sample = perf.read();
+    
+    if (perf.available()) {
+        for (size_t i = 0; i < PERF_EVENT_COUNT; ++i) {
+            assert(sample.valid[i] == perf.has(static_cast<PerfEvent>(i)));
+        }
+        if (perf.has(PerfEvent::Instructions)) assert(sample[PerfEvent::Instructions] > 100000);
+    } else {
+        assert(!perf.error().empty());
+        for (size_t i = 0; i < PERF_EVENT_COUNT; ++i) assert(!sample.valid[i]);
+    }
+    
+    PerfSample a, b;
+    a.values[0] = 10; a.valid[0] = true;
+    b.values[0] = 25; b.valid[0] = true; b.multiplexed = true;
+    PerfSample d = b.since(a);
+    assert(d[PerfEvent::Cycles] == 15 && d.valid[0] && d.multiplexed);
+    a += d;
+    assert(a[PerfEvent::Cycles] == 25 && a.multiplexed && !a.valid[1]);
+    
+    std::cout << "✓ test_perf_counters passed (" << (perf.available() ? "available" : perf.error()) << ")" << std::endl;
+}
+
+// A market order that fully fills a resting order must take its quantity
+// out of the level total, as limit sweeps do
+void test_market_sweep_level_qty() {
+    OrderBook book;
+    book.process_message(make_msg(MsgType::NewLimit, Side::Sell, 1, 100, 10));
+    book.process_message(make_msg(MsgType::NewLimit, Side::Sell, 2, 100, 10));
+    book.process_message(make_msg(MsgType::NewLimit, Side::Buy, 3, 90, 10));
+    book.process_message(make_msg(MsgType::NewLimit, Side::Buy, 4, 90, 10));
+    
+    book.process_message(make_msg(MsgType::NewMarket, Side::Buy, 5, 0, 15));
+    assert(book.best_ask_qty() == 5 && book.total_ask_qty() == 5);
+    book.process_message(make_msg(MsgType::NewMarket, Side::Sell, 6, 0, 10));
+    assert(book.best_bid_qty() == 10 && book.total_bid_qty() == 10);
+    
+    std::cout << "✓ test_market_sweep_level_qty passed" << std::endl;
+}
+
+// Checkpoint mid-stream, restore into a fresh book, replay the tail: the
+// restored book must behave exactly like the one that never stopped
+void test_snapshot_roundtrip() {
+    std::vector<Msg> msgs = make_random_flow(11, 20000, 35);
+    
+    const std::string mid_path = "test_snapshot_mid.snap";
+    const std::string live_path = "test_snapshot_live.snap";
+    const std::string restored_path = "test_snapshot_restored.snap";
+    const size_t split = msgs.size() / 2;
+    
+    BasicOrderBook<TradeCollector> live;   // reads get_trades()
+    for (size_t i = 0; i < split; ++i) live.process_message(msgs[i]);
+    assert(live.save_snapshot(mid_path));
+    
+    SnapshotFile file(mid_path);
+    assert(file.is_valid());
+    assert(file.header().sequence == split);
+    assert(file.size() == live.pool_stats().in_use);
+    Quantity bid_qty = 0;
+    for (const SnapshotOrder* r = file.begin(); r != file.begin() + file.header().bid_orders; ++r) {
+        bid_qty += r->qty;
+    }
+    assert(bid_qty == live.total_bid_qty());
+    
+    BasicOrderBook<TradeCollector> restored;
+    assert(restored.load_snapshot(mid_path));
+    assert(restored.get_total_messages() == live.get_total_messages());
+    assert(restored.get_total_trades() == live.get_total_trades());
+    assert(restored.best_bid() == live.best_bid() && restored.best_ask() == live.best_ask());
+    assert(restored.best_bid_qty() == live.best_bid_qty() && restored.best_ask_qty() == live.best_ask_qty());
+    assert(restored.get_trades().empty());
+    
+    size_t live_trades_before = live.get_trades().size();
+    for (size_t i = split; i < msgs.size(); ++i) {
+        live.process_message(msgs[i]);
+        restored.process_message(msgs[i]);
+    }
+    const auto& got = restored.get_trades();
+    const auto& want = live.get_trades();
+    assert(got.size() == want.size() - live_trades_before);
+    for (size_t i = 0; i < got.size(); ++i) {
+        const Trade& w = want[live_trades_before + i];
+        assert(got[i].buy_id == w.buy_id && got[i].sell_id == w.sell_id);
+        assert(got[i].price == w.price && got[i].qty == w.qty);
+    }
+    assert(restored.get_total_messages() == msgs.size());
+    assert(restored.total_bid_qty() == live.total_bid_qty());
+    assert(restored.total_ask_qty() == live.total_ask_qty());
+    
+    // Same resting orders in the same priority: identical checkpoints
+    assert(live.save_snapshot(live_path) && restored.save_snapshot(restored_path));
+    assert(read_file(live_path) == read_file(restored_path));
+    
+    // Only fresh books load; non-snapshots are rejected
+    assert(!restored.load_snapshot(mid_path));
+    OrderBook fresh;
+    assert(!fresh.load_snapshot("test_snapshot_missing.snap"));
+    {
+        std::ofstream out(restored_path, std::ios::binary | std::ios::trunc);
+        out << "ts_ns,MsgType,Side,OrderId,Price,Qty\n";
+    }
+    assert(!fresh.load_snapshot(restored_path));
+    assert(fresh.get_total_messages() == 0 && fresh.pool_stats().in_use == 0);
+    
+    // Crafted checkpoints that would break the book's invariants are
+    // rejected before anything is restored
+    const std::string good = read_file(mid_path);
+    SnapshotHeader header;
+    std::memcpy(&header, good.data(), sizeof(header));
+    assert(header.bid_orders >= 2 && header.order_count > header.bid_orders);
+    auto try_load = [&](auto&& edit) {
+        std::string bytes = good;
+        auto* h = reinterpret_cast<SnapshotHeader*>(bytes.data());
+        auto* r = reinterpret_cast<SnapshotOrder*>(bytes.data() + sizeof(SnapshotHeader));
+        edit(*h, r);
+        {
+            std::ofstream out(restored_path, std::ios::binary | std::ios::trunc);
+            out.write(bytes.data(), bytes.size());
+        }
+        OrderBook book;
+        bool loaded = book.load_snapshot(restored_path);
+        assert(loaded || (book.get_total_messages() == 0 && book.pool_stats().in_use == 0));
+        return loaded;
+    };
+    assert(try_load([](SnapshotHeader&, SnapshotOrder*) {}));
+    assert(!try_load([](SnapshotHeader& h, SnapshotOrder*) {
+        h.order_count = UINT64_MAX / sizeof(SnapshotOrder) + 2;   // byte size wraps
+    }));
+    assert(!try_load([](SnapshotHeader&, SnapshotOrder* r) { r[1].id = r[0].id; }));
+    assert(!try_load([](SnapshotHeader& h, SnapshotOrder* r) { r[h.bid_orders].id = r[0].id; }));
+    assert(!try_load([](SnapshotHeader& h, SnapshotOrder* r) {
+        r[0].price = r[h.bid_orders - 1].price - 1;   // best bid no longer first
+    }));
+    assert(!try_load([](SnapshotHeader& h, SnapshotOrder* r) { r[h.bid_orders].price = r[0].price; }));
+    assert(!try_load([](SnapshotHeader&, SnapshotOrder* r) { r[0].qty = 0; }));
+    
+    std::remove(mid_path.c_str());
+    std::remove(live_path.c_str());
+    std::remove(restored_path.c_str());
+    std::cout << "✓ test_snapshot_roundtrip passed" << std::endl;
+}
+
+// Journal from a child process that is SIGKILLed mid-stream: recovery must
+// rebuild exactly the book of the messages that reached the journal
+void test_journal_kill_and_recover() {
+#ifdef _WIN32
+    std::cout << "✓ test_journal_kill_and_recover skipped (needs fork)" << std::endl;
+#else
+    std::vector<Msg> msgs = make_random_flow(13, 20000, 35);
+    const std::string path = "test_journal.jrnl";
+    const std::string want_path = "test_journal_want.snap";
+    const std::string got_path = "test_journal_got.snap";
+    const size_t acked = 10000;      // the child waits until these are durable
+    const size_t killed_at = 15000;  // ... and dies after appending these
+    
+    pid_t pid = fork();
+    assert(pid >= 0);
+    if (pid == 0) {
+        JournalOptions options;
+        options.group_commit_us = 50;
+        options.max_batch = 256;
+        Journal journal(path, 0, options);
+        if (!journal.is_open()) _exit(1);
+        OrderBook book;
+        for (size_t i = 0; i < killed_at; ++i) {
+            journal.append(msgs[i]);
+            book.process_message(msgs[i]);
+            if (i + 1 == acked && !journal.wait_durable(i)) _exit(1);
+        }
+        raise(SIGKILL);  // no close(): whatever the writer had not committed is lost
+        _exit(1);
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+    assert(WIFSIGNALED(status) && WTERMSIG(status) == SIGKILL);
+    
+    BasicOrderBook<TradeCollector> recovered;   // compares get_trades()
+    JournalRecovery result = recover_journal(path, recovered);
+    assert(result.ok && result.skipped == 0);
+    size_t n = result.applied;
+    assert(n >= acked && n <= killed_at);
+    assert(recovered.get_total_messages() == n);
+    
+    BasicOrderBook<TradeCollector> reference;
+    for (size_t i = 0; i < n; ++i) reference.process_message(msgs[i]);
+    const auto& got = recovered.get_trades();
+    const auto& want = reference.get_trades();
+    assert(got.size() == want.size());
+    for (size_t i = 0; i < got.size(); ++i) {
+        assert(got[i].buy_id == want[i].buy_id && got[i].sell_id == want[i].sell_id);
+        assert(got[i].price == want[i].price && got[i].qty == want[i].qty);
+    }
+    assert(reference.save_snapshot(want_path) && recovered.save_snapshot(got_path));
+    assert(read_file(want_path) == read_file(got_path));
+    
+    // A frame cut off mid-write is ignored
+    {
+        std::ofstream out(path, std::ios::binary | std::ios::app);
+        JournalFrame frame{JOURNAL_FRAME_MAGIC, 100, n, 0};
+        out.write(reinterpret_cast<const char*>(&frame), sizeof(frame));
+        out.write("partial", 7);
+    }
+    OrderBook torn;
+    result = recover_journal(path, torn);
+    assert(result.ok && result.applied == n && result.torn_tail);
+    
+    // On top of a snapshot, journaled messages the snapshot covers are skipped
+    OrderBook early;
+    for (size_t i = 0; i < 5000; ++i) early.process_message(msgs[i]);
+    assert(early.save_snapshot(want_path));
+    OrderBook resumed;
+    assert(resumed.load_snapshot(want_path));
+    result = recover_journal(path, resumed);
+    assert(result.ok && result.skipped == 5000 && result.applied == n - 5000);
+    assert(reference.save_snapshot(want_path) && resumed.save_snapshot(got_path));
+    assert(read_file(want_path) == read_file(got_path));
+    
+    // A record that does not decode fails its frame even with a matching
+    // checksum: nothing from there on
+    {
+        std::fstream io(path, std::ios::binary | std::ios::in | std::ios::out);
+        JournalFrame frame;
+        io.seekg(sizeof(JournalHeader));
+        io.read(reinterpret_cast<char*>(&frame), sizeof(frame));
+        std::vector<BinaryMsgRecord> records(frame.count);
+        io.read(reinterpret_cast<char*>(records.data()), records.size() * sizeof(BinaryMsgRecord));
+        records[10].type = 200;
+        frame.checksum = journal_checksum(records.data(), records.size());
+        io.seekp(sizeof(JournalHeader));
+        io.write(reinterpret_cast<const char*>(&frame), sizeof(frame));
+        io.write(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(BinaryMsgRecord));
+    }
+    OrderBook undecodable;
+    result = recover_journal(path, undecodable);
+    assert(result.ok && result.applied == 0 && result.torn_tail);
+    
+    // A corrupt record fails its frame's checksum: nothing from there on
+    {
+        std::fstream io(path, std::ios::binary | std::ios::in | std::ios::out);
+        io.seekp(sizeof(JournalHeader) + sizeof(JournalFrame) + 10 * sizeof(BinaryMsgRecord));
+        io.put('\x7f');
+    }
+    OrderBook corrupt;
+    result = recover_journal(path, corrupt);
+    assert(result.ok && result.applied == 0 && result.torn_tail);
+    
+    // A journal that starts after the book's position leaves a gap
+    {
+        Journal late(path, 100);
+        assert(late.is_open());
+        late.append(msgs[100]);
+        assert(late.close() && late.records() == 1);
+    }
+    OrderBook gap;
+    result = recover_journal(path, gap);
+    assert(!result.ok && gap.get_total_messages() == 0);
+    
+    std::remove(path.c_str());
+    std::remove(want_path.c_str());
+    std::remove(got_path.c_str());
+    std::cout << "✓ test_journal_kill_and_recover passed (" << n << " of " << killed_at
+              << " messages durable at the kill)" << std::endl;
+#endif
+}
+
+// Modify keeps queue priority only for a same-price reduction; a price
+// change, a size increase or any CancelReplace re-queues the order in the
+// same pool slot, matching first if the new price crosses
+void test_modify_and_cancel_replace() {
+    BasicOrderBook<EventFanout<TradeCollector, RecordingHandler>> book;
+    auto send = [&book](MsgType type, OrderId id, Price price, Quantity qty, Side side = Side::Buy) {
+        book.process_message(make_msg(type, side, id, price, qty));
+    };
+    send(MsgType::NewLimit, 1, 100, 10);
+    send(MsgType::NewLimit, 2, 100, 10);
+    send(MsgType::NewLimit, 3, 100, 5);
+    const Order* slot1 = book.find_order(1);
+    const Order* slot2 = book.find_order(2);
+    size_t live = book.pool_stats().in_use;
+    
+    // Reduce in place: still first in the queue
+    send(MsgType::Modify, 1, 100, 4);
+    assert(book.find_order(1) == slot1 && slot1->qty == 4);
+    assert(book.best_bid_qty() == 19 && book.pool_stats().in_use == live);
+    
+    // Increase: same slot, behind #3 now
+    send(MsgType::Modify, 2, 100, 12);
+    assert(book.find_order(2) == slot2 && book.best_bid_qty() == 21);
+    
+    // Reduce by CancelReplace: re-queued behind #2
+    send(MsgType::CancelReplace, 1, 100, 3);
+    assert(book.find_order(1) == slot1 && book.best_bid_qty() == 20);
+    
+    // Queue is now 3, 2, 1
+    send(MsgType::NewMarket, 10, 0, 17, Side::Sell);
+    const auto& trades = book.handler().first().trades();
+    assert(trades.size() == 2);
+    assert(trades[0].buy_id == 3 && trades[0].qty == 5);
+    assert(trades[1].buy_id == 2 && trades[1].qty == 12);
+    send(MsgType::NewMarket, 11, 0, 1, Side::Sell);
+    assert(trades.back().buy_id == 1 && book.best_bid_qty() == 2);
+    
+    // Re-price to a new level: the old one goes away
+    send(MsgType::Modify, 1, 98, 2);
+    assert(book.best_bid() == 98 && book.best_bid_qty() == 2 && book.total_bid_qty() == 2);
+    
+    // Re-price through the ask: trades as its own id, the rest rests
+    send(MsgType::NewLimit, 20, 99, 1, Side::Sell);
+    send(MsgType::Modify, 1, 99, 2);
+    assert(trades.back().buy_id == 1 && trades.back().sell_id == 20 && trades.back().qty == 1);
+    assert(book.best_ask() == 0 && book.best_bid() == 99 && book.best_bid_qty() == 1);
+    assert(book.find_order(1) == slot1);
+    
+    // Fully filled by its own re-price: leaves the index and the pool
+    send(MsgType::NewLimit, 21, 100, 5, Side::Sell);
+    live = book.pool_stats().in_use;
+    send(MsgType::CancelReplace, 1, 100, 1);
+    assert(book.find_order(1) == nullptr && book.pool_stats().in_use == live - 1);
+    assert(book.best_ask_qty() == 4);
+    
+    // qty 0 cancels; unknown ids are ignored
+    send(MsgType::Modify, 21, 100, 0, Side::Sell);
+    assert(book.find_order(21) == nullptr && book.best_ask() == 0);
+    send(MsgType::Modify, 99, 100, 5);
+    send(MsgType::CancelReplace, 99, 100, 5);
+    assert(book.best_bid() == 0 && book.pool_stats().in_use == 0);
+    
+    const RecordingHandler& h = book.handler().second();
+    assert((h.modified == std::vector<uint64_t>{1, 2, 1, 1, 1, 1}));
+    assert((h.cancelled == std::vector<uint64_t>{21}));
+    
+    // Amends through the prefetch pipeline give the same results
+    std::vector<Msg> msgs = make_random_flow(17, 20000, 15, 30);
+    BasicOrderBook<TradeCollector> reference;   // compares get_trades()
+    for (const Msg& m : msgs) reference.process_message(m);
+    BasicOrderBook<TradeCollector> batched;
+    batched.process_batch(msgs);
+    assert(batched.get_trades().size() == reference.get_trades().size());
+    assert(batched.total_bid_qty() == reference.total_bid_qty());
+    assert(batched.total_ask_qty() == reference.total_ask_qty());
+    assert(batched.pool_stats().in_use == reference.pool_stats().in_use);
+    
+    std::cout << "✓ test_modify_and_cancel_replace passed" << std::endl;
+}
+
+// IOC drops its residual, FOK trades all or nothing and PostOnly never
+// trades; none of the three leaves anything in the pool or the index
+void test_time_in_force() {
+    BasicOrderBook<EventFanout<TradeCollector, RecordingHandler>> book;
+    auto send = [&book](TimeInForce tif, Side side, OrderId id, Price price, Quantity qty) {
+        Msg msg = make_msg(MsgType::NewLimit, side, id, price, qty);
+        msg.tif = tif;
+        book.process_message(msg);
+    };
+    const auto& trades = book.handler().first().trades();
+    send(TimeInForce::GTC, Side::Sell, 1, 100, 5);
+    send(TimeInForce::GTC, Side::Sell, 2, 101, 5);
+    send(TimeInForce::GTC, Side::Sell, 3, 102, 5);
+    
+    // IOC: takes #1, the other 3 lots are dropped
+    send(TimeInForce::IOC, Side::Buy, 10, 100, 8);
+    assert(trades.size() == 1 && trades[0].sell_id == 1 && trades[0].qty == 5);
+    assert(book.find_order(10) == nullptr && book.best_bid() == 0);
+    assert(book.pool_stats().in_use == 2);
+    
+    // IOC that crosses nothing is dropped whole
+    send(TimeInForce::IOC, Side::Buy, 11, 99, 4);
+    assert(trades.size() == 1 && book.pool_stats().in_use == 2);
+    
+    // FOK: 6 lots wanted, only 5 at or below 101, so nothing trades
+    send(TimeInForce::FOK, Side::Buy, 12, 101, 6);
+    assert(trades.size() == 1 && book.best_ask() == 101 && book.best_ask_qty() == 5);
+    assert(book.total_ask_qty() == 10);
+    
+    // FOK within reach: 5 @ 101 then 1 @ 102
+    send(TimeInForce::FOK, Side::Buy, 13, 102, 6);
+    assert(trades.size() == 3 && trades[1].sell_id == 2 && trades[2].sell_id == 3 && trades[2].qty == 1);
+    assert(book.find_order(13) == nullptr && book.best_ask() == 102 && book.best_ask_qty() == 4);
+    
+    // PostOnly: rejected on a cross, rests otherwise
+    send(TimeInForce::PostOnly, Side::Buy, 14, 102, 3);
+    assert(trades.size() == 3 && book.best_bid() == 0 && book.best_ask_qty() == 4);
+    send(TimeInForce::PostOnly, Side::Buy, 15, 101, 3);
+    assert(book.best_bid() == 101 && book.find_order(15) != nullptr);
+    send(TimeInForce::PostOnly, Side::Sell, 16, 101, 2);
+    assert(trades.size() == 3 && book.best_ask() == 102);
+    
+    // Sell side FOK at exactly the available quantity
+    send(TimeInForce::FOK, Side::Sell, 17, 101, 3);
+    assert(trades.size() == 4 && trades[3].buy_id == 15 && book.best_bid() == 0);
+    
+    const RecordingHandler& h = book.handler().second();
+    assert((h.killed == std::vector<uint64_t>{10, 11, 12, 14, 16}));
+    assert(h.killed_qty == 3 + 4 + 6 + 3 + 2);
+    assert((h.rested == std::vector<uint64_t>{1, 2, 3, 15}));
+    assert(book.pool_stats().in_use == 1);
+    
+    std::cout << "✓ test_time_in_force passed" << std::endl;
+}
+
+// Book builds differing only in policy (level backend, id index,
+// instrumentation) must produce identical trades and books
+struct CountedMapPolicy : DefaultBookPolicy {
+    template <Side S>
+    using book_side = MapBookSide<S>;
+    using order_index = FlatOrderIndex;
+    static constexpr bool count_events = true;
+};
+
+void test_book_policies() {
+    std::vector<Msg> msgs = make_random_flow(23, 30000, 15, 10);
+    for (size_t i = 0; i < msgs.size(); i += 7) {
+        msgs[i].tif = static_cast<TimeInForce>(i % 4);
+    }
+    BasicOrderBook<TradeCollector> reference;
+    BasicOrderBook<TradeCollector, CountedMapPolicy> counted;
+    for (const Msg& m : msgs) {
+        reference.process_message(m);
+        counted.process_message(m);
+    }
+    
+    const auto& a = reference.get_trades();
+    const auto& b = counted.get_trades();
+    assert(a.size() == b.size() && !a.empty());
+    for (size_t i = 0; i < a.size(); ++i) {
+        assert(a[i].buy_id == b[i].buy_id && a[i].sell_id == b[i].sell_id);
+        assert(a[i].price == b[i].price && a[i].qty == b[i].qty);
+    }
+    assert(reference.best_bid() == counted.best_bid() && reference.best_ask() == counted.best_ask());
+    assert(reference.total_bid_qty() == counted.total_bid_qty());
+    assert(reference.total_ask_qty() == counted.total_ask_qty());
+    assert(reference.pool_stats().in_use == counted.pool_stats().in_use);
+    
+    // Only the instrumented build counts
+    const BookCounters& c = counted.counters();
+    assert(c.levels_swept > 0 && c.resting_filled > 0 && c.orders_killed > 0);
+    assert(c.resting_filled <= b.size() && c.levels_swept <= b.size());
+    assert(reference.counters().levels_swept == 0 && reference.counters().orders_killed == 0);
+    
+    std::cout << "✓ test_book_policies passed" << std::endl;
+}
+
+// Cancels and amends go through the order's level handle, so handles must
+// follow levels the ladder moves when it re-anchors (window -> outlier tree
+// and back). Built on the ladder whatever ENABLE_PRICE_LADDER selects.
+struct LadderPolicy : DefaultBookPolicy {
+    template <Side S>
+    using book_side = PriceLadder<S>;
+};
+
+void test_level_handles_follow_recenter() {
+    BasicOrderBook<NullEventHandler, LadderPolicy> book;
+    auto send = [&book](MsgType type, OrderId id, Price price, Quantity qty) {
+        book.process_message(make_msg(type, Side::Buy, id, price, qty));
+    };
+    send(MsgType::NewLimit, 1, 100000, 10);
+    send(MsgType::NewLimit, 2, 100000, 20);
+    send(MsgType::NewLimit, 3, 100000, 30);
+    const PriceLevel* before = book.find_order(1)->level();
+    
+    // New touch far above: re-anchors, 100000 moves to the outlier tree
+    send(MsgType::NewLimit, 4, 900000, 5);
+    assert(book.best_bid() == 900000);
+    const PriceLevel* moved = book.find_order(1)->level();
+    assert(moved != before && book.find_order(3)->level() == moved);
+    
+    send(MsgType::Cancel, 2, 0, 0);
+    assert(moved->size() == 2 && moved->total_qty() == 40);
+    send(MsgType::Modify, 3, 100000, 25);
+    assert(book.total_bid_qty() == 40);
+    
+    // The window drains: the outlier level moves back in
+    send(MsgType::Cancel, 4, 0, 0);
+    assert(book.best_bid() == 100000 && book.best_bid_qty() == 35);
+    const PriceLevel* back = book.find_order(1)->level();
+    assert(back != moved && back == book.find_order(3)->level());
+    
+    send(MsgType::Cancel, 1, 0, 0);
+    assert(book.best_bid_qty() == 25);
+    send(MsgType::Cancel, 3, 0, 0);
+    assert(book.best_bid() == 0 && book.total_bid_qty() == 0 && book.pool_stats().in_use == 0);
+    
+    std::cout << "✓ test_level_handles_follow_recenter passed" << std::endl;
+}
+
+// Emptied levels near the touch keep their tree node for the next level
+// opened; both backends count level creation and removal
+void test_level_cache() {
+    MapBookSide<Side::Sell, 4> asks;
+    OrderPool pool;
+    for (Price p = 100; p < 106; ++p) {
+        asks.get_or_create(p);
+    }
+    asks.get_or_create(1000);
+    assert(asks.level_stats().created == 7 && asks.level_stats().cached == 0);
+    
+    // Far from the touch: freed, not cached
+    asks.erase(1000);
+    assert(asks.level_stats().destroyed == 1 && asks.level_stats().cached == 0);
+    
+    // The touch empties: its node is cached, then reused at another price
+    asks.get_or_create(100).add_order(pool.allocate(1, 7));
+    asks.erase(100);
+    assert(asks.best_price() == 101 && asks.level_stats().cached == 1);
+    PriceLevel& reused = asks.get_or_create(99);
+    assert(reused.empty() && reused.total_qty() == 0);
+    Order* order = pool.allocate(2, 3);
+    reused.add_order(order);
+    assert(asks.best_price() == 99 && asks.best_level().total_qty() == 3);
+    assert(order->level() == &asks.best_level() && order->price() == 99 && order->side() == Side::Sell);
+    LevelStats stats = asks.level_stats();
+    assert(stats.cache_hits == 1 && stats.cached == 0 && stats.created == 8);
+    
+    // The cache holds at most CacheTicks nodes
+    for (Price p : {99, 101, 102, 103, 104, 105}) {
+        asks.erase(p);
+    }
+    assert(asks.empty() && asks.level_stats().cached == 4);
+    for (Price p = 200; p < 206; ++p) {
+        asks.get_or_create(p);
+    }
+    std::vector<Price> prices;
+    asks.for_each([&](Price p, const PriceLevel&) { prices.push_back(p); });
+    assert((prices == std::vector<Price>{200, 201, 202, 203, 204, 205}));
+    stats = asks.level_stats();
+    assert(stats.cache_hits == 5 && stats.cached == 0);
+    assert(stats.created == 14 && stats.destroyed == 8);
+    
+    // Ladder: window slots and outliers alike
+    PriceLadder<Side::Buy> bids(64);
+    bids.get_or_create(1000);
+    bids.get_or_create(1001);
+    bids.get_or_create(1001);
+    bids.get_or_create(10);   // outlier
+    bids.erase(1000);
+    bids.erase(10);
+    bids.erase(10);
+    assert(bids.level_stats().created == 3 && bids.level_stats().destroyed == 2);
+    
+    // Books sum both sides
+    OrderBook book;
+    book.process_message(make_msg(MsgType::NewLimit, Side::Buy, 1, 100, 10));
+    book.process_message(make_msg(MsgType::NewLimit, Side::Sell, 2, 101, 10));
+    book.process_message(make_msg(MsgType::NewLimit, Side::Buy, 3, 101, 10));
+    assert(book.level_stats().created == 2 && book.level_stats().destroyed == 1);
+    
+    std::cout << "✓ test_level_cache passed" << std::endl;
+}
+
+// Queue links are 32-bit slots of the pool's region: they hold across
+// chunks, and price/side come from the level
+void test_compact_order_links() {
+    static_assert(sizeof(Order) == (ENABLE_ORDER_HOT_COLD_SPLIT ? 16 : 32));
+    OrderPool pool(4);   // tiny chunks: the queue spans three of them
+    PriceLevel level(250, Side::Sell);
+    std::vector<Order*> queue;
+    for (OrderId id = 1; id <= 10; ++id) {
+        queue.push_back(pool.allocate(id, static_cast<Quantity>(id)));
+        level.add_order(queue.back());
+    }
+    assert(pool.stats().chunks == 3 && level.size() == 10 && level.total_qty() == 55);
+    assert(queue[0]->ref() != 0 && queue[0]->slot(queue[9]->ref()) == queue[9]);
+    
+    level.remove_order(queue[3]);
+    level.remove_order(queue[4]);
+    level.remove_front();
+    std::vector<OrderId> ids;
+    for (const Order* o = level.get_front(); o != nullptr; o = o->next()) {
+        assert(o->level() == &level && o->price() == 250 && o->side() == Side::Sell);
+        ids.push_back(o->id());
+    }
+    assert((ids == std::vector<OrderId>{2, 3, 6, 7, 8, 9, 10}));
+    assert(level.total_qty() == 45 && queue[9]->prev() == queue[8] && queue[9]->next() == nullptr);
+    
+    // Released slots come back most recent first
+    pool.release(queue[3]);
+    pool.release(queue[4]);
+    assert(pool.allocate(11, 1) == queue[4] && pool.allocate(12, 1) == queue[3]);
+    assert(queue[3]->id() == 12 && pool.stats().in_use == 10);
+    
+    std::cout << "✓ test_compact_order_links passed" << std::endl;
+}
+
+// A sweep that takes a whole level retires it in one pass: every order is
+// filled and unindexed, the queue returns to the pool as one chain (reused
+// most recent first) and the level leaves the side
+void test_sweep_retires_levels() {
+    BasicOrderBook<TradeCollector, CountedMapPolicy> book;
+    auto send = [&book](MsgType type, Side side, OrderId id, Price price, Quantity qty) {
+        book.process_message(make_msg(type, side, id, price, qty));
+    };
+    send(MsgType::NewLimit, Side::Sell, 1, 100, 5);
+    send(MsgType::NewLimit, Side::Sell, 2, 100, 7);
+    send(MsgType::NewLimit, Side::Sell, 3, 100, 3);
+    send(MsgType::NewLimit, Side::Sell, 4, 101, 10);
+    send(MsgType::NewLimit, Side::Sell, 5, 102, 4);
+    const Order* slot1 = book.find_order(1);
+    const Order* slot4 = book.find_order(4);
+    const Order* slot5 = book.find_order(5);
+    
+    // Takes 100 and 101 whole, leaves 102 alone
+    send(MsgType::NewMarket, Side::Buy, 10, 0, 25);
+    const auto& trades = book.get_trades();
+    assert(trades.size() == 4);
+    for (size_t i = 0; i < 4; ++i) {
+        assert(trades[i].sell_id == i + 1 && trades[i].buy_id == 10);
+        assert(trades[i].price == (i < 3 ? 100 : 101));
+    }
+    assert(trades[1].qty == 7 && trades[3].qty == 10);
+    for (OrderId id = 1; id <= 4; ++id) assert(book.find_order(id) == nullptr);
+    assert(book.best_ask() == 102 && book.best_ask_qty() == 4 && book.pool_stats().in_use == 1);
+    assert(book.counters().resting_filled == 4 && book.counters().levels_swept == 2);
+    
+    // A limit order takes 102 whole too, and its residual rests
+    send(MsgType::NewLimit, Side::Buy, 11, 103, 6);
+    assert(book.best_ask() == 0 && book.best_bid() == 103 && book.best_bid_qty() == 2);
+    assert(book.get_total_trades() == 5 && book.counters().resting_filled == 5);
+    
+    // Chains go back most recent first: 102's (taken by #11's residual),
+    // then 101's, then 100's in queue order
+    assert(book.find_order(11) == slot5);
+    send(MsgType::NewLimit, Side::Sell, 20, 200, 1);
+    send(MsgType::NewLimit, Side::Sell, 21, 200, 1);
+    assert(book.find_order(20) == slot4 && book.find_order(21) == slot1);
+    assert(book.pool_stats().in_use == 3 && book.pool_stats().high_water_mark == 5);
+    
+    std::cout << "✓ test_sweep_retires_levels passed" << std::endl;
+}
+
+// A market order runs the limit matcher with an unbounded price: it must
+// trade exactly like an IOC limit priced through the whole opposite side
+template <typename Book>
+void check_market_matches_ioc(Side side) {
+    Side resting = side == Side::Buy ? Side::Sell : Side::Buy;
+    Price far = side == Side::Buy ? 1000000 : 1;
+    Book market, ioc;
+    for (Book* book : {&market, &ioc}) {
+        for (OrderId id = 1; id <= 9; ++id) {
+            Price offset = static_cast<Price>((id - 1) / 3);
+            Price price = resting == Side::Sell ? 100 + offset : 100 - offset;
+            book->process_message(make_msg(MsgType::NewLimit, resting, id, price, static_cast<Quantity>(id)));
+        }
+    }
+    
+    // Two whole levels and part of the third, then the rest and beyond
+    for (auto [id, qty] : {std::pair<OrderId, Quantity>{20, 23}, {21, 40}}) {
+        market.process_message(make_msg(MsgType::NewMarket, side, id, 0, qty));
+        Msg limit = make_msg(MsgType::NewLimit, side, id, far, qty);
+        limit.tif = TimeInForce::IOC;
+        ioc.process_message(limit);
+        
+        const auto& a = market.get_trades();
+        const auto& b = ioc.get_trades();
+        assert(a.size() == b.size());
+        for (size_t i = 0; i < a.size(); ++i) {
+            assert(a[i].buy_id == b[i].buy_id && a[i].sell_id == b[i].sell_id);
+            assert(a[i].price == b[i].price && a[i].qty == b[i].qty);
+        }
+        assert(market.best_bid() == ioc.best_bid() && market.best_ask() == ioc.best_ask());
+        assert(market.best_bid_qty() == ioc.best_bid_qty() && market.best_ask_qty() == ioc.best_ask_qty());
+        assert(market.pool_stats().in_use == ioc.pool_stats().in_use);
+        assert(market.counters().levels_swept == ioc.counters().levels_swept);
+        assert(market.counters().resting_filled == ioc.counters().resting_filled);
+    }
+    assert(market.get_total_trades() == 10 && market.pool_stats().in_use == 0);
+    assert(market.best_bid() == 0 && market.best_ask() == 0);
+    // Only the IOC reports its unfilled residual (counters are all zero in
+    // builds without count_events)
+    bool counted = ioc.counters().levels_swept > 0;
+    assert(market.counters().orders_killed == 0 && ioc.counters().orders_killed == (counted ? 1u : 0u));
+}
+
+void test_market_matches_ioc_limit() {
+    for (Side side : {Side::Buy, Side::Sell}) {
+        check_market_matches_ioc<BasicOrderBook<TradeCollector>>(side);
+        check_market_matches_ioc<BasicOrderBook<TradeCollector, CountedMapPolicy>>(side);
+    }
+    
+    std::cout << "✓ test_market_matches_ioc_limit passed" << std::endl;
+}
+
+// submit publishes before it returns: a lone message, or a short run, is
+// applied with no later submit, flush or stop to push it out
+void test_matching_engine_publishes_promptly() {
+    MatchingEngine engine(2);
+    auto applied = [&engine](uint64_t n) {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (engine.processed() < n && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::yield();
+        }
+        return engine.processed() == n;
+    };
+    
+    Msg lone = make_msg(MsgType::NewLimit, Side::Buy, 1, 1000, 5);
+    lone.symbol = 3;
+    assert(engine.submit(lone));
+    assert(applied(1));
+    
+    // Fewer than SUBMIT_BATCH messages, over both workers
+    std::vector<Msg> run;
+    for (uint32_t symbol = 0; symbol < 4; ++symbol) {
+        run.push_back(make_msg(MsgType::NewLimit, Side::Sell, 10 + symbol, 1010, 1));
+        run.back().symbol = symbol;
+    }
+    assert(engine.submit(run.data(), run.size()) == run.size());
+    assert(applied(5));
+    
+    engine.stop();
+    assert(engine.book(3)->best_bid() == 1000 && engine.book(3)->best_ask() == 1010);
+    assert(engine.symbol_count() == 4);
+    
+    std::cout << "✓ test_matching_engine_publishes_promptly passed" << std::endl;
+}
+
+void test_matching_engine_shares_order_pools() {
+    MatchingEngine engine(2);
+    const uint32_t symbols = 1000;
+    uint64_t id = 1;
+    for (uint32_t symbol = 0; symbol < symbols; ++symbol) {
+        Msg bid = make_msg(MsgType::NewLimit, Side::Buy, id++, 1000, 5);
+        bid.symbol = symbol;
+        assert(engine.submit(bid));
+        if (symbol % 4 < 2) {
+            Msg cancel = make_msg(MsgType::Cancel, Side::Buy, bid.id, 0, 0);
+            cancel.symbol = symbol;
+            assert(engine.submit(cancel));
+        }
+    }
+    engine.stop();
+    
+    // Each worker's books draw from its one pool: 500 symbols, 250 resting
+    for (size_t w = 0; w < engine.worker_count(); ++w) {
+        WorkerStats stats = engine.worker_stats(w);
+        assert(stats.books == symbols / 2);
+        assert(stats.orders.in_use == 250 && stats.orders.chunks == 1);
+    }
+    assert(engine.book(7)->pool_stats().in_use == engine.worker_stats(1).orders.in_use);
+    assert(engine.book(9)->best_bid() == 0 && engine.book(10)->best_bid() == 1000);
+    
+    std::cout << "✓ test_matching_engine_shares_order_pools passed" << std::endl;
+}
+
 int main() {
     std::cout << "Running OrderBook unit tests...\n" << std::endl;
     
@@ -144,6 +1712,35 @@ int main() {
         test_insert_at_best_price();
         test_immediate_cross();
         test_empty_book_market_order();
+        test_ladder_far_levels();
+        test_ladder_matches_map();
+        test_pool_recycles_orders();
+        test_order_index_backends();
+        test_csv_parse_line();
+        test_binary_record_roundtrip();
+        test_binary_file_rejects_invalid_records();
+        test_stream_reader_through_ring();
+        test_matching_engine_symbols();
+        test_event_handler_policy();
+        test_l2_deltas_and_conflation();
+        test_depth_snapshot_and_publisher();
+        test_process_batch_matches_sequential();
+        test_trades_carry_event_time();
+        test_latency_histogram();
+        test_perf_counters();
+        test_market_sweep_level_qty();
+        test_snapshot_roundtrip();
+        test_journal_kill_and_recover();
+        test_modify_and_cancel_replace();
+        test_time_in_force();
+        test_book_policies();
+        test_level_handles_follow_recenter();
+        test_level_cache();
+        test_compact_order_links();
+        test_sweep_retires_levels();
+        test_market_matches_ioc_limit();
+        test_matching_engine_publishes_promptly();
+        test_matching_engine_shares_order_pools();
         
         std::cout << "\n✓ All tests passed!" << std::endl;
         return 0;